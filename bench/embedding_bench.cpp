@@ -0,0 +1,116 @@
+// Throughput of EmbeddingModel::get_embeddings (one llama_encode per text)
+// versus get_embeddings_batch (many sequences per llama_encode), on the
+// prompts from intents.json. Also checks that both paths produce the same
+// vectors. Prints a JSON object.
+//
+// Usage: embedding_bench <model.gguf> [--intents PATH] [--count N]
+
+#include "loki/core/EmbeddingModel.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    float cosine(const std::vector<float> &a, const std::vector<float> &b) {
+        if (a.size() != b.size() || a.empty()) return 0.0f;
+        const float dot = std::inner_product(a.begin(), a.end(), b.begin(), 0.0f);
+        const float na = std::sqrt(std::inner_product(a.begin(), a.end(), a.begin(), 0.0f));
+        const float nb = std::sqrt(std::inner_product(b.begin(), b.end(), b.begin(), 0.0f));
+        return na == 0.0f || nb == 0.0f ? 0.0f : dot / (na * nb);
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: embedding_bench <model.gguf> [--intents PATH] [--count N]" << std::endl;
+        return 2;
+    }
+    // Library code logs progress to std::cout; keep stdout for the JSON report.
+    std::streambuf *stdout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+
+    const std::string model_path = argv[1];
+    std::string intents_path = "data/intents.json";
+    size_t count = 512;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--intents") intents_path = argv[i + 1];
+        else if (arg == "--count") count = std::stoul(argv[i + 1]);
+    }
+
+    std::ifstream intents_file(intents_path);
+    if (!intents_file.is_open()) {
+        std::cerr << "Error: failed to open intents file: " << intents_path << std::endl;
+        return 1;
+    }
+    std::vector<std::string> prompts;
+    for (const auto &group: nlohmann::json::parse(intents_file)) {
+        for (const auto &prompt: group.at("prompts")) {
+            prompts.push_back(prompt.get<std::string>());
+        }
+    }
+    if (prompts.empty()) {
+        std::cerr << "Error: no prompts in " << intents_path << std::endl;
+        return 1;
+    }
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < count; ++i) {
+        texts.push_back(prompts[i % prompts.size()]);
+    }
+
+    auto model = EmbeddingModel::create(model_path);
+    if (!model) {
+        std::cerr << "Error: failed to load embedding model: " << model_path << std::endl;
+        return 1;
+    }
+    model->get_embeddings("warm up"); // First encode allocates compute buffers
+
+    auto start = Clock::now();
+    std::vector<std::vector<float> > single;
+    single.reserve(texts.size());
+    for (const auto &text: texts) {
+        single.push_back(model->get_embeddings(text));
+    }
+    const double single_s = seconds_since(start);
+
+    start = Clock::now();
+    const std::vector<std::vector<float> > batched = model->get_embeddings_batch(texts);
+    const double batch_s = seconds_since(start);
+
+    float min_cosine = 1.0f;
+    size_t failed = 0;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (batched[i].empty() || single[i].empty()) {
+            failed++;
+            continue;
+        }
+        min_cosine = std::min(min_cosine, cosine(single[i], batched[i]));
+    }
+
+    const nlohmann::json report = {
+        {"model", model_path},
+        {"sentences", texts.size()},
+        {"single_s", single_s},
+        {"single_sentences_per_s", single_s > 0.0 ? texts.size() / single_s : 0.0},
+        {"batch_s", batch_s},
+        {"batch_sentences_per_s", batch_s > 0.0 ? texts.size() / batch_s : 0.0},
+        {"speedup", batch_s > 0.0 ? single_s / batch_s : 0.0},
+        {"min_cosine_single_vs_batch", min_cosine},
+        {"failed", failed}
+    };
+    std::cout.rdbuf(stdout_buf);
+    std::cout << report.dump(2) << std::endl;
+    return 0;
+}
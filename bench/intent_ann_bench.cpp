@@ -0,0 +1,145 @@
+// Benchmark for FastClassifier's optional HNSW index.
+//
+// Builds an HnswIndex over synthetic, clustered intent embeddings (one
+// "intent" per 50 prompts, each prompt a paraphrase-like point near its centre)
+// and compares it to the exact EmbeddingMatrix scan: build time, per-query
+// latency percentiles, and recall@1 against the exact best match for a range
+// of ef_search values, plus the cost of adding one prompt to a copy of the
+// index (what FastClassifier::learn does) against a full rebuild. Prints one
+// JSON object per catalog size.
+//
+// Usage: intent_ann_bench [--dim N] [--queries N] [--max-prompts N] [--M N] [--ef-construction N]
+
+#include "loki/intent/EmbeddingMatrix.h"
+#include "loki/intent/HnswIndex.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using loki::intent::EmbeddingMatrix;
+using loki::intent::HnswIndex;
+using loki::intent::HnswOptions;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double us_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        const size_t rank = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+        return values[std::min(rank, values.size() - 1)];
+    }
+
+    // A point near `centre`: `spread` controls how similar paraphrases are.
+    std::vector<float> jitter(std::mt19937 &rng, const std::vector<float> &centre, float spread) {
+        std::normal_distribution<float> noise(0.0f, spread);
+        std::vector<float> v = centre;
+        for (float &x: v) x += noise(rng);
+        EmbeddingMatrix::normalize(v);
+        return v;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t dim = 384;
+    size_t n_queries = 500;
+    size_t max_prompts = 100000;
+    HnswOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const size_t value = std::stoul(argv[i + 1]);
+        if (arg == "--dim") dim = value;
+        else if (arg == "--queries") n_queries = value;
+        else if (arg == "--max-prompts") max_prompts = value;
+        else if (arg == "--M") options.M = value;
+        else if (arg == "--ef-construction") options.ef_construction = value;
+    }
+
+    for (size_t n_prompts: {1000, 10000, 100000}) {
+        if (n_prompts > max_prompts) break;
+
+        std::mt19937 rng(7);
+        std::normal_distribution<float> unit(0.0f, 1.0f);
+        const size_t n_intents = std::max<size_t>(10, n_prompts / 50);
+        std::vector<std::vector<float> > centres(n_intents, std::vector<float>(dim));
+        for (auto &c: centres) {
+            for (float &x: c) x = unit(rng);
+            EmbeddingMatrix::normalize(c);
+        }
+
+        EmbeddingMatrix matrix;
+        std::uniform_int_distribution<size_t> pick(0, n_intents - 1);
+        for (size_t i = 0; i < n_prompts; ++i) {
+            matrix.add_row(jitter(rng, centres[i % n_intents], 0.04f));
+        }
+        std::vector<std::vector<float> > queries;
+        for (size_t q = 0; q < n_queries; ++q) {
+            queries.push_back(jitter(rng, centres[pick(rng)], 0.05f));
+        }
+
+        auto start = Clock::now();
+        HnswIndex index(matrix, options);
+        const double build_ms = us_since(start) / 1000.0;
+
+        // One learned prompt: copy the matrix and graph, append a row, extend.
+        start = Clock::now();
+        EmbeddingMatrix grown = matrix;
+        grown.add_row(jitter(rng, centres[pick(rng)], 0.04f));
+        HnswIndex extended(index, grown);
+        extended.extend();
+        const double add_one_ms = us_since(start) / 1000.0;
+
+        std::vector<size_t> truth(n_queries);
+        std::vector<double> exact_us;
+        for (size_t q = 0; q < n_queries; ++q) {
+            start = Clock::now();
+            truth[q] = matrix.best_match(queries[q].data()).index;
+            exact_us.push_back(us_since(start));
+        }
+
+        nlohmann::json sweep = nlohmann::json::array();
+        for (size_t ef: {8, 16, 32, 64, 128, 256}) {
+            std::vector<double> ann_us;
+            size_t hits = 0;
+            for (size_t q = 0; q < n_queries; ++q) {
+                start = Clock::now();
+                const auto matches = index.search(queries[q].data(), 1, ef);
+                ann_us.push_back(us_since(start));
+                hits += !matches.empty() && matches.front().index == truth[q];
+            }
+            sweep.push_back({
+                {"ef_search", ef},
+                {"recall_at_1", static_cast<double>(hits) / n_queries},
+                {"p50_us", percentile(ann_us, 50)},
+                {"p99_us", percentile(ann_us, 99)},
+                {"speedup_p50", percentile(exact_us, 50) / std::max(percentile(ann_us, 50), 1e-3)}
+            });
+        }
+
+        const nlohmann::json row = {
+            {"prompts", n_prompts},
+            {"dim", dim},
+            {"queries", n_queries},
+            {"kernel", EmbeddingMatrix::kernel_name()},
+            {"M", index.options().M},
+            {"ef_construction", index.options().ef_construction},
+            {"levels", index.max_level() + 1},
+            {"build_ms", build_ms},
+            {"copy_and_add_one_ms", add_one_ms},
+            {"exact_p50_us", percentile(exact_us, 50)},
+            {"exact_p99_us", percentile(exact_us, 99)},
+            {"hnsw", sweep}
+        };
+        std::cout << row.dump() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Microbenchmark for FastClassifier's similarity search.
+//
+// Compares the original per-intent cosine similarity (two norms recomputed
+// with std::inner_product over separately allocated vectors) against the
+// pre-normalized EmbeddingMatrix scan, for catalogs of 100 to 100k prompts.
+// Embeddings are random Gaussian vectors of the MiniLM dimension, so no model is
+// needed. Prints one JSON object per catalog size.
+//
+// Usage: intent_matrix_bench [--dim N] [--queries N]
+
+#include "loki/intent/EmbeddingMatrix.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using loki::intent::EmbeddingMatrix;
+
+namespace {
+    // The pre-matrix implementation, kept verbatim as the baseline.
+    float cosine_similarity(const std::vector<float> &a, const std::vector<float> &b) {
+        if (a.size() != b.size() || a.empty()) {
+            return 0.0f;
+        }
+        float dot_product = std::inner_product(a.begin(), a.end(), b.begin(), 0.0f);
+        float norm_a = std::sqrt(std::inner_product(a.begin(), a.end(), a.begin(), 0.0f));
+        float norm_b = std::sqrt(std::inner_product(b.begin(), b.end(), b.begin(), 0.0f));
+
+        if (norm_a == 0.0f || norm_b == 0.0f) {
+            return 0.0f;
+        }
+        return dot_product / (norm_a * norm_b);
+    }
+
+    std::vector<float> random_vector(std::mt19937 &rng, size_t dim) {
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        std::vector<float> v(dim);
+        for (float &x: v) x = dist(rng);
+        return v;
+    }
+
+    double ns_per_query(std::chrono::steady_clock::time_point start, size_t queries) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / queries;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t dim = 384;
+    size_t n_queries = 200;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--dim") dim = std::stoul(argv[i + 1]);
+        else if (arg == "--queries") n_queries = std::stoul(argv[i + 1]);
+    }
+
+    std::mt19937 rng(42);
+    std::vector<std::vector<float> > queries;
+    for (size_t q = 0; q < n_queries; ++q) {
+        queries.push_back(random_vector(rng, dim));
+    }
+
+    for (size_t n_prompts: {100, 1000, 10000, 100000}) {
+        std::vector<std::vector<float> > prompts;
+        EmbeddingMatrix matrix;
+        prompts.reserve(n_prompts);
+        for (size_t i = 0; i < n_prompts; ++i) {
+            prompts.push_back(random_vector(rng, dim));
+            matrix.add_row(prompts.back());
+        }
+
+        // Large catalogs get fewer queries so every size finishes in seconds.
+        const size_t runs = std::max<size_t>(1, std::min(n_queries, n_queries * 1000 / n_prompts));
+
+        std::vector<size_t> baseline_best(runs);
+        std::vector<size_t> matrix_best(runs);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < runs; ++q) {
+            float best_score = -2.0f;
+            size_t best = 0;
+            for (size_t i = 0; i < prompts.size(); ++i) {
+                const float score = cosine_similarity(queries[q], prompts[i]);
+                if (score > best_score) {
+                    best_score = score;
+                    best = i;
+                }
+            }
+            baseline_best[q] = best;
+        }
+        const double baseline_ns = ns_per_query(start, runs);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < runs; ++q) {
+            // The query is normalized once per classify() call, so time it too.
+            std::vector<float> query = queries[q];
+            EmbeddingMatrix::normalize(query);
+            matrix_best[q] = matrix.best_match(query.data()).index;
+        }
+        const double matrix_ns = ns_per_query(start, runs);
+
+        // Summation order differs, so near-ties can legitimately flip.
+        size_t agree = 0;
+        for (size_t q = 0; q < runs; ++q) {
+            agree += baseline_best[q] == matrix_best[q];
+        }
+
+        const nlohmann::json row = {
+            {"prompts", n_prompts},
+            {"dim", dim},
+            {"queries", runs},
+            {"kernel", EmbeddingMatrix::kernel_name()},
+            {"baseline_us_per_query", baseline_ns / 1000.0},
+            {"matrix_us_per_query", matrix_ns / 1000.0},
+            {"speedup", matrix_ns > 0.0 ? baseline_ns / matrix_ns : 0.0},
+            {"ns_per_prompt", matrix_ns / n_prompts},
+            {"best_match_agreement", static_cast<double>(agree) / runs}
+        };
+        std::cout << row.dump() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+// LLM backend comparison: Ollama over HTTP versus llama.cpp in-process.
+//
+// Runs the same labelled transcripts through IntentClassifier on each backend,
+// so both see byte-identical system and user prompts, and prints one JSON
+// object per backend with end-to-end, first-token and complete-JSON latency
+// percentiles and how often the expected type/action came back. A final object
+// reports how often the two backends agreed with each other. Each backend runs
+// once with the grammar-constrained decoding the app uses (LLM_GRAMMAR=1) and
+// once without, to show the parse-failure rate and token count it saves. The
+// first run of each is a warm-up and is not measured. Prompt evaluation time and
+// tokens show the system-prompt KV reuse; set LLM_PROMPT_CACHE=0 to compare.
+//
+// The backends are configured from the .env file like the app (OLLAMA_HOST,
+// OLLAMA_MODEL, LLM_MODEL_PATH, LLM_THREADS, LLM_GPU_LAYERS); for a fair
+// comparison point both at the same model and quantization.
+//
+// Usage: llm_backend_bench [--env PATH] [--runs N] [--only ollama|llama] [--grammar on|off|both]
+
+#include "loki/core/Config.h"
+#include "loki/core/LlamaBackend.h"
+#include "loki/core/OllamaClient.h"
+#include "loki/intent/IntentClassifier.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+    struct LabelledTranscript {
+        const char *text;
+        const char *type;
+        const char *action;
+    };
+
+    // Phrased so the embedding fast path would likely miss them, which is
+    // when the LLM runs in the app.
+    const LabelledTranscript TRANSCRIPTS[] = {
+        {"could you fire up the web browser for me", "system_control", "launch_application"},
+        {"i need notepad open", "system_control", "launch_application"},
+        {"shut spotify down", "system_control", "close_application"},
+        {"it's way too loud in here", "system_control", "set_volume"},
+        {"bump the sound up a bit", "system_control", "set_volume"},
+        {"look up the weather in berlin tomorrow", "search", "web_search"},
+        {"find me a recipe for banana bread", "search", "web_search"},
+        {"do you know what time it is", "general", "get_time"},
+        {"how are you doing today", "general", "conversation"},
+        {"what's twelve times seven", "calculation", "evaluate_expression"},
+        {"how much is 15 percent of 80", "calculation", "evaluate_expression"},
+        {"blue window seventeen carpet", "unknown", ""}
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // Nearest-rank percentile.
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::min(values.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    json summarize(const std::vector<double> &values) {
+        double sum = 0.0;
+        for (double v: values) sum += v;
+        return {
+            {"count", values.size()},
+            {"mean_ms", values.empty() ? 0.0 : sum / values.size()},
+            {"p50_ms", percentile(values, 50)},
+            {"p95_ms", percentile(values, 95)},
+            {"max_ms", values.empty() ? 0.0 : *std::max_element(values.begin(), values.end())}
+        };
+    }
+
+    struct BackendRun {
+        std::string name;
+        bool constrained;
+        std::vector<loki::intent::Intent> answers; // Last measured run, one per transcript
+    };
+
+    BackendRun run_backend(loki::core::ILLMBackend &backend, bool constrained, int runs, std::ostream &report) {
+        loki::intent::IntentClassifier classifier(backend, constrained);
+        BackendRun result;
+        result.name = backend.get_name();
+        result.constrained = constrained;
+        std::vector<double> total_ms, first_token_ms, json_complete_ms, prompt_eval_ms;
+        size_t correct = 0, measured = 0, stopped_early = 0, tokens = 0, prompt_tokens_evaluated = 0;
+        size_t prefix_losses = 0;
+
+        for (int run = 0; run <= runs; ++run) {
+            result.answers.clear();
+            for (const auto &t: TRANSCRIPTS) {
+                const auto start = Clock::now();
+                const auto intent = classifier.classify(t.text);
+                const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                result.answers.push_back(intent);
+                if (run == 0) continue; // Warm-up
+                const auto metrics = backend.last_metrics();
+                total_ms.push_back(ms);
+                if (metrics.first_token_ms >= 0.0) first_token_ms.push_back(metrics.first_token_ms);
+                if (metrics.json_complete_ms >= 0.0) json_complete_ms.push_back(metrics.json_complete_ms);
+                if (metrics.prompt_eval_ms >= 0.0) {
+                    prompt_eval_ms.push_back(metrics.prompt_eval_ms);
+                    prompt_tokens_evaluated += std::max(0, metrics.prompt_tokens_evaluated);
+                    prefix_losses += metrics.prompt_prefix_lost;
+                }
+                stopped_early += metrics.stopped_early;
+                tokens += metrics.chunks;
+                correct += intent.type == t.type && intent.action == t.action;
+                measured++;
+            }
+        }
+
+        const auto parse = classifier.parse_stats(); // Includes the warm-up run
+        report << json{
+            {"backend", result.name},
+            {"grammar", constrained},
+            {"runs", runs},
+            {"requests", measured},
+            {"total", summarize(total_ms)},
+            {"first_token", summarize(first_token_ms)},
+            {"json_complete", summarize(json_complete_ms)},
+            {"prompt_eval", summarize(prompt_eval_ms)},
+            {
+                "mean_prompt_tokens_evaluated",
+                prompt_eval_ms.empty() ? 0.0 : static_cast<double>(prompt_tokens_evaluated) / prompt_eval_ms.size()
+            },
+            {"prompt_prefix_losses", prefix_losses},
+            {"stopped_early", stopped_early},
+            // Streamed chunks; one per token on both backends.
+            {"mean_tokens", measured ? static_cast<double>(tokens) / measured : 0.0},
+            {"accuracy", measured ? static_cast<double>(correct) / measured : 0.0},
+            {"parse_failures", parse.failures},
+            {"parse_failure_rate", parse.responses ? static_cast<double>(parse.failures) / parse.responses : 0.0}
+        }.dump() << std::endl;
+        return result;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // Library code logs progress to std::cout; keep stdout for the JSON report.
+    std::streambuf *stdout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+
+    std::string env_path = ".env";
+    std::string only;
+    std::string grammar = "both";
+    int runs = 3;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--env") env_path = argv[i + 1];
+        else if (arg == "--runs") runs = std::max(1, std::stoi(argv[i + 1]));
+        else if (arg == "--only") only = argv[i + 1];
+        else if (arg == "--grammar") grammar = argv[i + 1];
+    }
+
+    // Relative paths are taken from the .env file's directory, as in loki_bench.
+    loki::core::Config config(env_path);
+    config.set_base_dir(std::filesystem::path(env_path).parent_path().string());
+    const nlohmann::json llm_options = {
+        {"num_ctx", 1024}, {"temperature", 0.0}, {"top_k", 1}, {"top_p", 1.0}, {"max_new_tokens", 128}
+    };
+
+    std::vector<std::unique_ptr<loki::core::ILLMBackend> > backends;
+    if (only.empty() || only == "ollama") {
+        backends.push_back(std::make_unique<loki::core::OllamaClient>(
+            config.get("OLLAMA_HOST", "http://localhost:11434"), config.get("OLLAMA_MODEL", "dolphin-phi"),
+            llm_options, config.get("OLLAMA_KEEP_ALIVE", "30m")));
+    }
+    if (only.empty() || only == "llama") {
+        auto llama_options = loki::core::LlamaBackendOptions::from_config(config);
+        llama_options.n_ctx = llm_options["num_ctx"].get<uint32_t>();
+        llama_options.max_tokens = llm_options["max_new_tokens"].get<int>();
+        auto llama = loki::core::LlamaBackend::create(config.get_path("LLM_MODEL_PATH", "llm.gguf"), llama_options);
+        if (llama) {
+            backends.push_back(std::move(llama));
+        } else {
+            std::cerr << "WARNING: LLM_MODEL_PATH could not be loaded; skipping the llama backend." << std::endl;
+        }
+    }
+    if (backends.empty()) {
+        std::cerr << "Error: no LLM backend available." << std::endl;
+        return 1;
+    }
+
+    std::ostream report(stdout_buf);
+    std::vector<BackendRun> results;
+    for (auto &backend: backends) {
+        if (grammar != "off") results.push_back(run_backend(*backend, true, runs, report));
+        if (grammar != "on") results.push_back(run_backend(*backend, false, runs, report));
+    }
+
+    for (size_t a = 0; a < results.size(); ++a) {
+        for (size_t b = a + 1; b < results.size(); ++b) {
+            if (results[a].constrained != results[b].constrained) continue;
+            size_t agree = 0;
+            for (size_t i = 0; i < results[a].answers.size(); ++i) {
+                agree += results[a].answers[i].type == results[b].answers[i].type &&
+                        results[a].answers[i].action == results[b].answers[i].action;
+            }
+            report << json{
+                {"case", "agreement"},
+                {"backends", {results[a].name, results[b].name}},
+                {"grammar", results[a].constrained},
+                {"transcripts", results[a].answers.size()},
+                {"same_type_and_action", agree}
+            }.dump() << std::endl;
+        }
+    }
+    return 0;
+}
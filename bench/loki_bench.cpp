@@ -0,0 +1,484 @@
+// Offline end-to-end benchmark.
+//
+// Feeds every WAV file in a directory through the same path a live command
+// takes after the wake word - endpointer -> Whisper -> FastClassifier ->
+// IntentClassifier (on a fast-path miss) -> AgentManager - and prints per-stage
+// latency percentiles, real-time factor and the fast-path hit rate as JSON.
+// No microphone, Porcupine key or Qt is needed; the LLM stage can be skipped
+// with --no-llm when no Ollama server is available. --speculative starts the
+// LLM request alongside the embedding search (LLM_SPECULATIVE in the app);
+// compare "llm_path" latency with and without it. LLM_BACKEND=llama in the
+// .env file runs the LLM in-process instead of through Ollama. Fast-path misses
+// go through the semantic LLM cache first ("semantic_cache"); it starts empty
+// every run, so --runs 2 or more shows its hit rate on repeated commands.
+// --learn turns on FastClassifier's online learning (INTENT_LEARN in the app)
+// without touching the learned-prompts file; with --runs 2 or more,
+// "fast_path_hit_rate_by_run" shows the fast path taking over LLM answers.
+//
+// Usage: loki_bench <wav_dir> [--env PATH] [--runs N] [--no-llm] [--speculative] [--learn] [--system-agent]
+//                   [--out FILE]
+
+#define MINIAUDIO_IMPLEMENTATION
+#include "miniaudio/miniaudio.h"
+
+#include "loki/AgentManager.h"
+#include "loki/agents/CalculationAgent.h"
+#include "loki/core/Config.h"
+#include "loki/core/EmbeddingModel.h"
+#include "loki/core/Endpointer.h"
+#include "loki/core/LlamaBackend.h"
+#include "loki/core/OllamaClient.h"
+#include "loki/core/Whisper.h"
+#include "loki/intent/FastClassifier.h"
+#include "loki/intent/IntentClassifier.h"
+#include "loki/intent/SemanticIntentCache.h"
+#include "nlohmann/json.hpp"
+
+#ifdef _WIN32
+#include "loki/agents/SystemControlAgent.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+    // Same routing thresholds as LokiWorker.
+    constexpr float FAST_PATH_CONFIDENCE = 0.95f;
+    constexpr float AGENT_CONFIDENCE = 0.7f;
+    constexpr int SAMPLE_RATE = 16000;
+    constexpr size_t FRAME_SAMPLES = 512; // Porcupine's frame length, which is what the endpointer sees live
+
+    struct Options {
+        std::string wav_dir;
+        std::string env_path = ".env";
+        std::string out_path;
+        int runs = 1;
+        bool use_llm = true;
+        bool speculative = false;
+        bool learn = false;
+        bool system_agent = false;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double ms_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Decodes any format miniaudio understands to 16 kHz mono float.
+    bool load_wav(const std::string &path, std::vector<float> &samples) {
+        ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 1, SAMPLE_RATE);
+        ma_decoder decoder;
+        if (ma_decoder_init_file(path.c_str(), &config, &decoder) != MA_SUCCESS) {
+            return false;
+        }
+        samples.clear();
+        float chunk[4096];
+        ma_uint64 frames_read = 0;
+        while (ma_decoder_read_pcm_frames(&decoder, chunk, 4096, &frames_read) == MA_SUCCESS && frames_read > 0) {
+            samples.insert(samples.end(), chunk, chunk + frames_read);
+        }
+        ma_decoder_uninit(&decoder);
+        return !samples.empty();
+    }
+
+    // Nearest-rank percentile.
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::min(values.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    json summarize(const std::vector<double> &values) {
+        double sum = 0.0;
+        for (double v: values) sum += v;
+        return {
+            {"count", values.size()},
+            {"mean_ms", values.empty() ? 0.0 : sum / values.size()},
+            {"p50_ms", percentile(values, 50)},
+            {"p95_ms", percentile(values, 95)},
+            {"p99_ms", percentile(values, 99)},
+            {"max_ms", values.empty() ? 0.0 : *std::max_element(values.begin(), values.end())}
+        };
+    }
+
+    bool parse_args(int argc, char *argv[], Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--env" && i + 1 < argc) {
+                options.env_path = argv[++i];
+            } else if (arg == "--out" && i + 1 < argc) {
+                options.out_path = argv[++i];
+            } else if (arg == "--runs" && i + 1 < argc) {
+                options.runs = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--no-llm") {
+                options.use_llm = false;
+            } else if (arg == "--speculative") {
+                options.speculative = true;
+            } else if (arg == "--learn") {
+                options.learn = true;
+            } else if (arg == "--system-agent") {
+                options.system_agent = true;
+            } else if (options.wav_dir.empty() && arg.rfind("--", 0) != 0) {
+                options.wav_dir = arg;
+            } else {
+                return false;
+            }
+        }
+        return !options.wav_dir.empty();
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // Library code logs progress to std::cout; keep stdout for the JSON report.
+    std::streambuf *stdout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        std::cerr << "Usage: loki_bench <wav_dir> [--env PATH] [--runs N] [--no-llm] [--speculative] [--learn] [--system-agent]"
+                " [--out FILE]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::filesystem::path> wav_files;
+    std::error_code ec;
+    for (const auto &entry: std::filesystem::directory_iterator(options.wav_dir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".wav") {
+            wav_files.push_back(entry.path());
+        }
+    }
+    std::sort(wav_files.begin(), wav_files.end());
+    if (wav_files.empty()) {
+        std::cerr << "Error: no .wav files found in '" << options.wav_dir << "'" << std::endl;
+        return 1;
+    }
+
+    // Models are configured exactly like the app, from the same .env keys and
+    // with the same option builders. Relative paths are taken from the .env
+    // file's directory, which is the app's directory for the app.
+    loki::core::Config config(options.env_path);
+    config.set_base_dir(std::filesystem::path(options.env_path).parent_path().string());
+    auto whisper = Whisper::create(config.get_path("WHISPER_MODEL_PATH", "ggml-base.en.bin"));
+    if (!whisper) {
+        std::cerr << "Error: failed to load the Whisper model." << std::endl;
+        return 1;
+    }
+    auto embedding_model = EmbeddingModel::create(
+        config.get_path("EMBEDDING_MODEL_PATH", "all-MiniLM-L6-v2.Q4_K_S.gguf"));
+    if (!embedding_model) {
+        std::cerr << "Error: failed to load the embedding model." << std::endl;
+        return 1;
+    }
+    auto classifier_options = loki::intent::FastClassifier::Options::from_config(config);
+    // A run is one pass over a fixed catalog: no reloads, and learned prompts stay
+    // in memory, so every bench run starts from the intents file alone.
+    classifier_options.watch_intents_file = false;
+    classifier_options.online_learning = options.learn && options.use_llm;
+    classifier_options.learned_prompts_path.clear();
+    loki::intent::FastClassifier fast_classifier(config.get_path("INTENTS_JSON_PATH", "intents.json"), *embedding_model,
+                                                 classifier_options);
+
+    std::unique_ptr<loki::core::ILLMBackend> llm_backend;
+    std::unique_ptr<loki::intent::IntentClassifier> llm_classifier;
+    if (options.use_llm) {
+        nlohmann::json llm_options = {
+            {"num_ctx", 1024}, {"temperature", 0.0}, {"top_k", 1}, {"top_p", 1.0}, {"max_new_tokens", 128}
+        };
+        if (config.get("LLM_BACKEND", "ollama") == "llama") {
+            auto llama_options = loki::core::LlamaBackendOptions::from_config(config);
+            llama_options.n_ctx = llm_options["num_ctx"].get<uint32_t>();
+            llama_options.max_tokens = llm_options["max_new_tokens"].get<int>();
+            llm_backend = loki::core::LlamaBackend::create(config.get_path("LLM_MODEL_PATH", "llm.gguf"),
+                                                           llama_options);
+            if (!llm_backend) {
+                std::cerr << "Error: failed to load LLM_MODEL_PATH." << std::endl;
+                return 1;
+            }
+        } else {
+            llm_backend = std::make_unique<loki::core::OllamaClient>(
+                config.get("OLLAMA_HOST", "http://localhost:11434"), config.get("OLLAMA_MODEL", "dolphin-phi"),
+                llm_options, config.get("OLLAMA_KEEP_ALIVE", "30m"));
+        }
+        llm_classifier = std::make_unique<loki::intent::IntentClassifier>(
+            *llm_backend, config.get("LLM_GRAMMAR", "1") == "1");
+    }
+
+    // Same settings as the app, but never persisted, so every bench run starts cold.
+    std::unique_ptr<loki::intent::SemanticIntentCache> semantic_cache;
+    auto semantic_options = loki::intent::SemanticIntentCache::Options::from_config(config);
+    semantic_options.path.clear();
+    if (llm_classifier && semantic_options.capacity > 0) {
+        semantic_cache = std::make_unique<loki::intent::SemanticIntentCache>(
+            fast_classifier, embedding_model->model_hash(), semantic_options);
+    }
+
+    // Only side-effect-free agents by default; the system agent really launches apps.
+    AgentManager agent_manager;
+    agent_manager.register_agent(std::make_unique<CalculationAgent>());
+#ifdef _WIN32
+    if (options.system_agent) {
+        agent_manager.register_agent(std::make_unique<SystemControlAgent>());
+    }
+#else
+    if (options.system_agent) {
+        std::cerr << "WARNING: --system-agent is only available on Windows." << std::endl;
+    }
+#endif
+
+    auto endpointer = loki::core::Endpointer::create(config, SAMPLE_RATE);
+
+    std::map<std::string, std::vector<double> > stage_ms;
+    json utterances = json::array();
+    double total_audio_ms = 0.0;
+    double total_processing_ms = 0.0;
+    double total_stt_ms = 0.0;
+    size_t classified = 0;
+    size_t fast_path_hits = 0;
+    std::vector<size_t> classified_by_run(options.runs, 0);
+    std::vector<size_t> fast_path_hits_by_run(options.runs, 0);
+    size_t llm_calls = 0;
+    size_t llm_stopped_early = 0; // Stream closed as soon as the JSON object was complete
+    size_t failed_files = 0;
+
+    for (int run = 0; run < options.runs; ++run) {
+        for (const auto &path: wav_files) {
+            std::vector<float> audio;
+            if (!load_wav(path.string(), audio)) {
+                std::cerr << "WARNING: could not decode '" << path.string() << "', skipping." << std::endl;
+                failed_files++;
+                continue;
+            }
+            const double audio_ms = audio.size() * 1000.0 / SAMPLE_RATE;
+            json record = {{"file", path.filename().string()}, {"run", run}, {"audio_ms", audio_ms}};
+
+            // Endpointing runs frame by frame, as on the audio thread.
+            auto start = Clock::now();
+            endpointer->reset();
+            std::vector<float> command;
+            command.reserve(audio.size());
+            for (size_t offset = 0; offset < audio.size(); offset += FRAME_SAMPLES) {
+                const size_t n = std::min(FRAME_SAMPLES, audio.size() - offset);
+                command.insert(command.end(), audio.begin() + offset, audio.begin() + offset + n);
+                if (endpointer->process(audio.data() + offset, n)) break;
+            }
+            endpointer->trim(command);
+            const double vad_ms = ms_since(start);
+            stage_ms["vad"].push_back(vad_ms);
+            record["command_ms"] = command.size() * 1000.0 / SAMPLE_RATE;
+
+            start = Clock::now();
+            const std::string transcript = whisper->process_audio(command);
+            const double stt_ms = ms_since(start);
+            stage_ms["stt"].push_back(stt_ms);
+            record["transcript"] = transcript;
+
+            double fast_ms = 0.0;
+            double llm_ms = 0.0;
+            double agent_ms = 0.0;
+            std::string path_taken = "none";
+            if (!transcript.empty()) {
+                classified++;
+                classified_by_run[run]++;
+                start = Clock::now();
+                std::unique_ptr<loki::intent::IntentClassifier::Speculation> speculation;
+                auto fast_result = fast_classifier.classify_lexical(transcript);
+                if (!fast_result.has_match) {
+                    if (llm_classifier && options.speculative) {
+                        speculation = llm_classifier->classify_speculative(transcript);
+                    }
+                    fast_result = fast_classifier.classify_embedding(transcript);
+                }
+                fast_ms = ms_since(start);
+                stage_ms["fast_classifier"].push_back(fast_ms);
+
+                loki::intent::Intent intent;
+                bool have_intent = false;
+                if (fast_result.has_match && fast_result.confidence >= FAST_PATH_CONFIDENCE) {
+                    fast_path_hits++;
+                    fast_path_hits_by_run[run]++;
+                    path_taken = "fast";
+                    intent = {fast_result.type, fast_result.action, fast_result.parameters, fast_result.confidence};
+                    have_intent = true;
+                } else if (semantic_cache && semantic_cache->lookup(transcript, intent)) {
+                    path_taken = "semantic_cache";
+                    stage_ms["semantic_cache_path"].push_back(ms_since(start));
+                    have_intent = true;
+                } else if (llm_classifier) {
+                    llm_calls++;
+                    path_taken = "llm";
+                    start = Clock::now();
+                    // With --speculative this is only the wait left after the embedding search.
+                    intent = speculation ? speculation->get() : llm_classifier->classify(transcript);
+                    llm_ms = ms_since(start);
+                    stage_ms["llm_classifier"].push_back(llm_ms);
+                    stage_ms["llm_path"].push_back(fast_ms + llm_ms);
+                    const auto metrics = llm_backend->last_metrics();
+                    if (metrics.first_token_ms >= 0.0) stage_ms["llm_first_token"].push_back(metrics.first_token_ms);
+                    if (metrics.prompt_eval_ms >= 0.0) stage_ms["llm_prompt_eval"].push_back(metrics.prompt_eval_ms);
+                    if (metrics.json_complete_ms >= 0.0) stage_ms["llm_json_complete"].push_back(
+                        metrics.json_complete_ms);
+                    llm_stopped_early += metrics.stopped_early;
+                    if (semantic_cache) semantic_cache->insert(transcript, intent);
+                    if (fast_classifier.learn(transcript, intent)) record["learned"] = true;
+                    have_intent = true;
+                } else {
+                    path_taken = "llm_skipped";
+                }
+                if (speculation) {
+                    start = Clock::now();
+                    speculation.reset(); // Cancels an unused request
+                    stage_ms["speculation_cancel"].push_back(ms_since(start));
+                }
+
+                if (have_intent) {
+                    record["intent"] = {
+                        {"type", intent.type}, {"action", intent.action}, {"parameters", intent.parameters},
+                        {"confidence", intent.confidence}
+                    };
+                    if (intent.confidence >= AGENT_CONFIDENCE) {
+                        start = Clock::now();
+                        record["response"] = agent_manager.dispatch(intent);
+                        agent_ms = ms_since(start);
+                        stage_ms["agent"].push_back(agent_ms);
+                    }
+                }
+            }
+            record["path"] = path_taken;
+
+            const double processing_ms = vad_ms + stt_ms + fast_ms + llm_ms + agent_ms;
+            stage_ms["total"].push_back(processing_ms);
+            record["processing_ms"] = processing_ms;
+            total_audio_ms += audio_ms;
+            total_processing_ms += processing_ms;
+            total_stt_ms += stt_ms;
+            utterances.push_back(std::move(record));
+        }
+    }
+
+    json stages = json::object();
+    for (const auto &[name, values]: stage_ms) {
+        stages[name] = summarize(values);
+    }
+
+    const auto transcript_cache = fast_classifier.transcript_cache_stats();
+    const auto lexical = fast_classifier.lexical_stats();
+    json speculation = json::object();
+    if (llm_classifier) {
+        const auto spec = llm_classifier->speculation_stats();
+        speculation = {
+            {"started", spec.started}, {"used", spec.used}, {"cancelled", spec.cancelled},
+            {"discarded", spec.discarded}
+        };
+    }
+    json llm_parse = json::object();
+    if (llm_classifier) {
+        const auto parse = llm_classifier->parse_stats();
+        llm_parse = {
+            {"responses", parse.responses}, {"failures", parse.failures},
+            {"failure_rate", parse.responses ? static_cast<double>(parse.failures) / parse.responses : 0.0},
+            {"constrained", llm_backend->stats().constrained}
+        };
+    }
+    json semantic = json::object();
+    if (semantic_cache) {
+        const auto cache = semantic_cache->stats();
+        semantic = {
+            {"lookups", cache.lookups}, {"hits", cache.hits}, {"exact_hits", cache.exact_hits},
+            {"rejected", cache.rejected}, {"size", cache.size},
+            {"hit_rate", cache.lookups ? static_cast<double>(cache.hits) / cache.lookups : 0.0}
+        };
+    }
+    json llm_prompt = json::object();
+    if (llm_backend && llm_backend->stats().prompt_evals > 0) {
+        const auto llm = llm_backend->stats();
+        llm_prompt = {
+            {"requests", llm.prompt_evals},
+            {"mean_tokens", static_cast<double>(llm.prompt_tokens_total) / llm.prompt_evals}, // 0 for Ollama
+            {"mean_tokens_evaluated", static_cast<double>(llm.prompt_tokens_evaluated_total) / llm.prompt_evals},
+            // Requests that re-evaluated the system prompt because a decode error dropped it
+            {"prefix_losses", llm.prompt_prefix_losses}
+        };
+    }
+    json learning = json::object();
+    if (options.learn && options.use_llm) {
+        const auto learned = fast_classifier.learning_stats();
+        learning = {
+            {"learned", learned.learned}, {"duplicates", learned.duplicates}, {"capped", learned.capped},
+            {"rejected", learned.rejected}, {"learned_prompts", learned.learned_prompts}
+        };
+    }
+    json hit_rate_by_run = json::array();
+    for (int run = 0; run < options.runs; ++run) {
+        hit_rate_by_run.push_back(classified_by_run[run] > 0
+                                      ? static_cast<double>(fast_path_hits_by_run[run]) / classified_by_run[run]
+                                      : 0.0);
+    }
+    const uint64_t lexical_hits = lexical.exact_hits + lexical.stripped_hits;
+    json report = {
+        {"wav_dir", options.wav_dir},
+        {"files", wav_files.size()},
+        {"runs", options.runs},
+        {"failed_files", failed_files},
+        {"llm_enabled", options.use_llm},
+        {"llm_speculative", options.speculative},
+        {"llm_backend", llm_backend ? llm_backend->get_name() : "none"},
+        {"llm_parse", llm_parse},
+        {"llm_prompt", llm_prompt},
+        {"semantic_cache", semantic},
+        {"audio_s", total_audio_ms / 1000.0},
+        // Processing time per second of input audio; below 1.0 is faster than real time.
+        {"rtf", total_audio_ms > 0.0 ? total_processing_ms / total_audio_ms : 0.0},
+        {"stt_rtf", total_audio_ms > 0.0 ? total_stt_ms / total_audio_ms : 0.0},
+        {"classified", classified},
+        {"fast_path_hits", fast_path_hits},
+        {"fast_path_hit_rate", classified > 0 ? static_cast<double>(fast_path_hits) / classified : 0.0},
+        {"fast_path_hit_rate_by_run", hit_rate_by_run},
+        {"learning", learning},
+        {"llm_calls", llm_calls},
+        {"llm_stopped_early", llm_stopped_early},
+        {"speculation", speculation},
+        {
+            "lexical", {
+                {"lookups", lexical.lookups},
+                {"exact_hits", lexical.exact_hits},
+                {"stripped_hits", lexical.stripped_hits},
+                {"hit_rate", lexical.lookups > 0 ? static_cast<double>(lexical_hits) / lexical.lookups : 0.0}
+            }
+        },
+        {
+            "transcript_cache", {
+                {"hits", transcript_cache.hits},
+                {"misses", transcript_cache.misses},
+                {"evictions", transcript_cache.evictions}
+            }
+        },
+        {"stages", stages},
+        {"utterances", utterances}
+    };
+
+    std::cout.rdbuf(stdout_buf);
+    const std::string output = report.dump(2);
+    if (!options.out_path.empty()) {
+        std::ofstream out(options.out_path);
+        if (!out.is_open()) {
+            std::cerr << "Error: failed to open '" << options.out_path << "' for writing." << std::endl;
+            return 1;
+        }
+        out << output << std::endl;
+        std::cerr << "Wrote benchmark report to '" << options.out_path << "'" << std::endl;
+    } else {
+        std::cout << output << std::endl;
+    }
+    return 0;
+}
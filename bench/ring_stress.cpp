@@ -0,0 +1,178 @@
+// Stress test for the capture ring between the miniaudio callback and the
+// audio thread.
+//
+// A producer thread writes one device period at a time on the device's
+// cadence, as data_callback does. The consumer drains the ring in wake-word
+// frames like LokiWorker::audio_thread_loop, sleeping in wait_for() when the
+// ring is short, but every --stall-every-ms it stops reading for a
+// decode-length interval to stand in for the worker being busy in
+// Whisper::process_audio. Each stall length is a separate case. Samples
+// carry their frame index, so the consumer can also check that every frame
+// arrives once and in order.
+//
+// Prints one JSON object per case. Cases whose stall fits in the ring must show
+// no dropped frames, no overruns and no gaps; the exit code is 1 if any does.
+//
+// Usage: ring_stress [--seconds N] [--sample-rate N] [--period N] [--ring-ms N]
+//                    [--stall-every-ms N] [--stalls 0,500,1500,2500]
+
+#include "loki/core/AudioRingBuffer.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using loki::core::AudioRingBuffer;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Float holds integers exactly up to 2^24, which is over 17 minutes at 16 kHz.
+    constexpr uint64_t SAMPLE_INDEX_MASK = (1u << 24) - 1;
+
+    struct Options {
+        int seconds = 10;
+        int sample_rate = 16000;
+        size_t period = 512; // Porcupine's frame length, which is also the device period
+        int ring_ms = 2000; // CAPTURE_RING_MS default
+        int stall_every_ms = 3000;
+        std::vector<int> stalls = {0, 500, 1500, 2500};
+    };
+
+    struct CaseResult {
+        uint64_t periods = 0;
+        double max_producer_late_ms = 0.0;
+        uint64_t frames_read = 0;
+        uint64_t discontinuities = 0;
+        uint64_t stalls = 0;
+        uint64_t wakeups = 0; // wait_for() calls by the consumer
+        uint64_t idle_wakeups = 0; // ... that returned without a full frame
+        size_t max_fill = 0;
+    };
+
+    std::vector<int> parse_list(const std::string &s) {
+        std::vector<int> out;
+        std::stringstream ss(s);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) out.push_back(std::stoi(item));
+        }
+        return out;
+    }
+
+    CaseResult run_case(const Options &opt, int stall_ms, AudioRingBuffer &ring) {
+        CaseResult result;
+        std::atomic<bool> producing{true};
+        const auto period_duration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(opt.period) / opt.sample_rate));
+        const uint64_t total_periods = static_cast<uint64_t>(opt.seconds) * opt.sample_rate / opt.period;
+
+        std::thread producer([&] {
+            std::vector<float> period(opt.period);
+            uint64_t next_index = 0;
+            auto deadline = Clock::now();
+            for (uint64_t p = 0; p < total_periods; ++p) {
+                deadline += period_duration;
+                std::this_thread::sleep_until(deadline);
+                const double late_ms = std::chrono::duration<double, std::milli>(Clock::now() - deadline).count();
+                result.max_producer_late_ms = std::max(result.max_producer_late_ms, late_ms);
+
+                for (float &x: period) x = static_cast<float>(next_index++ & SAMPLE_INDEX_MASK);
+                ring.write(period.data(), period.size());
+                ++result.periods;
+            }
+            producing.store(false);
+            ring.interrupt();
+        });
+
+        // The consumer waits on the ring exactly as the audio thread does.
+        const auto max_wait = std::chrono::milliseconds(500);
+        const auto stall_interval = std::chrono::milliseconds(opt.stall_every_ms);
+        std::vector<float> chunk(opt.period);
+        uint64_t expected = 0;
+        auto next_stall = Clock::now() + stall_interval;
+        while (producing.load() || ring.available() >= chunk.size()) {
+            if (stall_ms > 0 && Clock::now() >= next_stall) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+                next_stall = Clock::now() + stall_interval;
+                ++result.stalls;
+            }
+            result.max_fill = std::max(result.max_fill, ring.available());
+            if (ring.available() < chunk.size()) {
+                ++result.wakeups;
+                if (!ring.wait_for(chunk.size(), max_wait)) ++result.idle_wakeups;
+                continue;
+            }
+            const size_t n = ring.read(chunk.data(), chunk.size());
+            for (size_t i = 0; i < n; ++i) {
+                const auto index = static_cast<uint64_t>(chunk[i]);
+                if (index != (expected & SAMPLE_INDEX_MASK)) {
+                    // Frames were lost (or reordered); resynchronize on what arrived.
+                    ++result.discontinuities;
+                    expected = index;
+                }
+                ++expected;
+            }
+            result.frames_read += n;
+        }
+        producer.join();
+        return result;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds") opt.seconds = std::stoi(argv[i + 1]);
+        else if (arg == "--sample-rate") opt.sample_rate = std::stoi(argv[i + 1]);
+        else if (arg == "--period") opt.period = std::stoul(argv[i + 1]);
+        else if (arg == "--ring-ms") opt.ring_ms = std::stoi(argv[i + 1]);
+        else if (arg == "--stall-every-ms") opt.stall_every_ms = std::stoi(argv[i + 1]);
+        else if (arg == "--stalls") opt.stalls = parse_list(argv[i + 1]);
+    }
+
+    bool failed = false;
+    for (int stall_ms: opt.stalls) {
+        // Sized exactly as LokiWorker sizes the capture ring.
+        AudioRingBuffer ring(static_cast<size_t>(opt.sample_rate) * opt.ring_ms / 1000);
+        const CaseResult r = run_case(opt, stall_ms, ring);
+
+        // The ring rounds up to a power of two, so it can absorb a little more than ring_ms.
+        const double capacity_ms = 1000.0 * ring.capacity() / opt.sample_rate;
+        const double period_ms = 1000.0 * opt.period / opt.sample_rate;
+        const bool must_not_drop = stall_ms + period_ms < capacity_ms;
+        const bool ok = ring.dropped_frames() == 0 && ring.overruns() == 0 && r.discontinuities == 0;
+        if (must_not_drop && !ok) failed = true;
+
+        const nlohmann::json row = {
+            {"stall_ms", stall_ms},
+            {"stall_every_ms", opt.stall_every_ms},
+            {"stalls", r.stalls},
+            {"ring_capacity_ms", capacity_ms},
+            {"period_frames", opt.period},
+            {"periods", r.periods},
+            {"frames_written", ring.frames_written()},
+            {"frames_read", r.frames_read},
+            {"dropped_frames", ring.dropped_frames()},
+            {"overruns", ring.overruns()},
+            {"discontinuities", r.discontinuities},
+            {"max_fill_pct", 100.0 * r.max_fill / ring.capacity()},
+            {"consumer_wakeups_per_s", static_cast<double>(r.wakeups) / opt.seconds},
+            {"consumer_idle_wakeups", r.idle_wakeups},
+            {"blocking_wait", ring.can_block()},
+            {"max_producer_late_ms", r.max_producer_late_ms},
+            {"expect_no_drops", must_not_drop},
+            {"pass", !must_not_drop || ok}
+        };
+        std::cout << row.dump() << std::endl;
+    }
+    return failed ? 1 : 0;
+}
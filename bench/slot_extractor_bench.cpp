@@ -0,0 +1,187 @@
+// Benchmark for FastClassifier's parameter extraction.
+//
+// The baseline is the original chain of std::string::find calls from
+// FastClassifier::classify, kept verbatim, run against SlotExtractor loaded
+// with the same vocabulary. A second pass grows the app-name vocabulary from 3
+// to 3000 phrases and compares a find() loop over every phrase (what adding
+// slots to the old chain amounts to) with the single automaton pass.
+// Prints one JSON object per case.
+//
+// Usage: slot_extractor_bench [--iterations N]
+
+#include "loki/intent/SlotExtractor.h"
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using loki::intent::SlotExtractor;
+
+namespace {
+    // The pre-SlotExtractor implementation, kept verbatim as the baseline.
+    nlohmann::json legacy_parameters(const std::string &action, const std::string &normalized_transcript) {
+        nlohmann::json parameters = nlohmann::json::object();
+        if (action == "launch_application") {
+            if (normalized_transcript.find("chrome") != std::string::npos || normalized_transcript.find(
+                    "browser") !=
+                std::string::npos) {
+                parameters["name"] = "chrome";
+            } else if (normalized_transcript.find("firefox") != std::string::npos) {
+                parameters["name"] = "firefox";
+            } else if (normalized_transcript.find("notepad") != std::string::npos) {
+                parameters["name"] = "notepad";
+            } // ... etc.
+        } else if (action == "set_volume") {
+            if (normalized_transcript.find("up") != std::string::npos || normalized_transcript.find("increase")
+                !=
+                std::string::npos || normalized_transcript.find("louder") != std::string::npos) {
+                parameters["direction"] = "up";
+            } else if (normalized_transcript.find("down") != std::string::npos || normalized_transcript.find(
+                           "decrease")
+                       != std::string::npos || normalized_transcript.find("quieter") != std::string::npos) {
+                parameters["direction"] = "down";
+            } else if (normalized_transcript.find("mute") != std::string::npos) {
+                parameters["direction"] = "mute";
+            }
+        }
+        return parameters;
+    }
+
+    // The same chain generalised to any number of phrases: first phrase found wins.
+    nlohmann::json find_loop(const std::vector<std::pair<std::string, std::string> > &phrases,
+                             const std::string &normalized_transcript) {
+        nlohmann::json parameters = nlohmann::json::object();
+        for (const auto &[phrase, value]: phrases) {
+            if (normalized_transcript.find(phrase) != std::string::npos) {
+                parameters["name"] = value;
+                break;
+            }
+        }
+        return parameters;
+    }
+
+    template<typename Fn>
+    double ns_per_call(size_t iterations, const std::vector<std::pair<std::string, std::string> > &cases, Fn &&fn) {
+        size_t sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t it = 0; it < iterations; ++it) {
+            for (const auto &[action, text]: cases) {
+                sink += fn(action, text).size();
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (sink == static_cast<size_t>(-1)) std::cerr << sink;
+        return ns / (iterations * cases.size());
+    }
+
+    std::string random_word(std::mt19937 &rng) {
+        std::uniform_int_distribution<int> length(4, 10);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::string word;
+        for (int i = length(rng); i > 0; --i) word += static_cast<char>(letter(rng));
+        return word;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t iterations = 20000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::string(argv[i]) == "--iterations") iterations = std::stoul(argv[i + 1]);
+    }
+
+    // --- The shipped vocabulary, limited to what the old chain understood ---
+    SlotExtractor extractor;
+    for (const char *phrase: {"chrome", "browser"}) extractor.add_phrase("launch_application", "name", phrase, "chrome");
+    extractor.add_phrase("launch_application", "name", "firefox", "firefox");
+    extractor.add_phrase("launch_application", "name", "notepad", "notepad");
+    for (const char *phrase: {"up", "increase", "louder"}) extractor.add_phrase("set_volume", "direction", phrase, "up");
+    for (const char *phrase: {"down", "decrease", "quieter"}) {
+        extractor.add_phrase("set_volume", "direction", phrase, "down");
+    }
+    extractor.add_phrase("set_volume", "direction", "mute", "mute");
+    extractor.compile();
+
+    const std::vector<std::pair<std::string, std::string> > cases = {
+        {"launch_application", "open google chrome"},
+        {"launch_application", "launch the browser"},
+        {"launch_application", "could you open firefox for me"},
+        {"launch_application", "run notepad"},
+        {"launch_application", "pull up the terminal"},
+        {"set_volume", "turn the volume up"},
+        {"set_volume", "make it a little quieter please"},
+        {"set_volume", "decrease volume"},
+        {"set_volume", "mute the sound"},
+        {"set_volume", "unmute"},
+        {"set_volume", "set volume to fifty percent"},
+        {"get_time", "what time is it"}
+    };
+
+    size_t disagreements = 0;
+    nlohmann::json differences = nlohmann::json::array();
+    for (const auto &[action, text]: cases) {
+        const auto legacy = legacy_parameters(action, text);
+        const auto compiled = extractor.extract(action, text);
+        if (legacy != compiled) {
+            disagreements++;
+            differences.push_back({{"text", text}, {"find_chain", legacy}, {"automaton", compiled}});
+        }
+    }
+
+    const double legacy_ns = ns_per_call(iterations, cases, legacy_parameters);
+    const double automaton_ns = ns_per_call(iterations, cases, [&](const std::string &action, const std::string &text) {
+        return extractor.extract(action, text);
+    });
+    std::cout << nlohmann::json{
+        {"case", "shipped_vocabulary"},
+        {"transcripts", cases.size()},
+        {"find_chain_ns", legacy_ns},
+        {"automaton_ns", automaton_ns},
+        {"speedup", legacy_ns / automaton_ns},
+        {"disagreements", disagreements},
+        // Expected: the chain matches inside words ("mute" in "unmute").
+        {"differences", differences}
+    }.dump() << std::endl;
+
+    // --- Scaling with vocabulary size ---
+    for (size_t n_phrases: {3, 30, 300, 3000}) {
+        std::mt19937 rng(11);
+        std::vector<std::pair<std::string, std::string> > phrases;
+        SlotExtractor scaled;
+        for (size_t i = 0; i < n_phrases; ++i) {
+            const std::string phrase = random_word(rng);
+            const std::string value = "app" + std::to_string(i);
+            phrases.emplace_back(phrase, value);
+            scaled.add_phrase("launch_application", "name", phrase, value);
+        }
+        scaled.compile();
+
+        std::vector<std::pair<std::string, std::string> > queries;
+        std::uniform_int_distribution<size_t> pick(0, n_phrases - 1);
+        for (int q = 0; q < 64; ++q) {
+            queries.emplace_back("launch_application", "please open " + phrases[pick(rng)].first + " for me");
+        }
+
+        const size_t scaled_iterations = std::max<size_t>(1, iterations / n_phrases);
+        const double loop_ns = ns_per_call(scaled_iterations, queries,
+                                           [&](const std::string &, const std::string &text) {
+                                               return find_loop(phrases, text);
+                                           });
+        const double scaled_ns = ns_per_call(scaled_iterations, queries,
+                                             [&](const std::string &action, const std::string &text) {
+                                                 return scaled.extract(action, text);
+                                             });
+        std::cout << nlohmann::json{
+            {"case", "vocabulary_scaling"},
+            {"phrases", n_phrases},
+            {"automaton_states", scaled.state_count()},
+            {"find_loop_ns", loop_ns},
+            {"automaton_ns", scaled_ns},
+            {"speedup", loop_ns / scaled_ns}
+        }.dump() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef LOKI_AUDIORINGBUFFER_H
+#define LOKI_AUDIORINGBUFFER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace loki {
+    namespace core {
+        // A lock-free single-producer/single-consumer ring of float samples.
+        // The producer is the real-time capture callback, the consumer is the
+        // worker's audio thread. All storage is allocated up front so that
+        // neither side ever locks or allocates, and the producer never blocks.
+        //
+        // The consumer can sleep in wait_for() until enough frames arrive. The
+        // producer only wakes it when it is actually waiting, through an OS
+        // primitive that shares no user-space lock with the consumer (a futex on
+        // Linux, an auto-reset event on Windows). Elsewhere wait_for() polls.
+        class AudioRingBuffer {
+        public:
+            // Capacity is rounded up to the next power of two.
+            explicit AudioRingBuffer(size_t capacity_frames);
+
+            ~AudioRingBuffer();
+
+            AudioRingBuffer(const AudioRingBuffer &) = delete;
+
+            AudioRingBuffer &operator=(const AudioRingBuffer &) = delete;
+
+            // Producer side. Copies as many frames as fit and returns that count.
+            // Frames that do not fit are counted as dropped.
+            size_t write(const float *frames, size_t count);
+
+            // Consumer side. Copies up to `count` frames into `out` and returns that count.
+            size_t read(float *out, size_t count);
+
+            // Number of frames currently waiting to be read.
+            size_t available() const;
+
+            // Consumer side. Returns true once at least `count` frames are available,
+            // false if the next wakeup (a write, interrupt() or `timeout`) still
+            // found fewer. Returns at most one wakeup later, so callers loop.
+            bool wait_for(size_t count, std::chrono::milliseconds timeout);
+
+            // Wakes a wait_for() in progress, e.g. so the consumer sees a stop flag.
+            void interrupt();
+
+            // False if the wake primitive is missing or failed to initialize;
+            // wait_for() then polls every millisecond.
+            bool can_block() const;
+
+            size_t capacity() const { return buffer_.size(); }
+
+            // Total frames ever accepted / rejected by write().
+            uint64_t frames_written() const { return written_.load(std::memory_order_relaxed); }
+            uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+            // Number of write() calls that could not store the whole period.
+            uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+        private:
+            std::vector<float> buffer_;
+            size_t mask_;
+
+            // Monotonic indices, masked on access. Kept on separate cache lines
+            // so the producer and consumer do not false-share.
+            alignas(64) std::atomic<size_t> head_{0}; // next slot to write (producer-owned)
+            alignas(64) std::atomic<size_t> tail_{0}; // next slot to read (consumer-owned)
+
+            // Set by the consumer while it sleeps in wait_for(); the producer only
+            // signals when it finds this set.
+            alignas(64) std::atomic<bool> consumer_waiting_{false};
+            std::atomic<uint32_t> wake_word_{0}; // Futex word: 1 once signalled (Linux)
+            void *wake_event_ = nullptr; // Auto-reset event HANDLE (Windows)
+
+            void signal();
+
+            void sleep(std::chrono::milliseconds timeout);
+
+            alignas(64) std::atomic<uint64_t> written_{0};
+            std::atomic<uint64_t> dropped_{0};
+            std::atomic<uint64_t> overruns_{0};
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_AUDIORINGBUFFER_H
@@ -0,0 +1,101 @@
+#ifndef LOKI_BOUNDEDQUEUE_H
+#define LOKI_BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace loki {
+    namespace core {
+        // A blocking, capacity-limited FIFO used to hand work between threads.
+        // Consumers sleep on a condition variable until an item (or close())
+        // arrives, so an idle pipeline costs no wakeups at all.
+        template<typename T>
+        class BoundedQueue {
+        public:
+            explicit BoundedQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {
+            }
+
+            // Never blocks. Returns false if the queue is full or closed.
+            bool try_push(T item) {
+                {
+                    std::lock_guard<std::mutex> lock(mtx_);
+                    if (closed_ || items_.size() >= capacity_) return false;
+                    items_.push_back(std::move(item));
+                }
+                not_empty_.notify_one();
+                return true;
+            }
+
+            // Blocks while the queue is full. Returns false if the queue was closed.
+            bool push(T item) {
+                {
+                    std::unique_lock<std::mutex> lock(mtx_);
+                    not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+                    if (closed_) return false;
+                    items_.push_back(std::move(item));
+                }
+                not_empty_.notify_one();
+                return true;
+            }
+
+            // Blocks until an item is available. Returns std::nullopt once the
+            // queue has been closed and drained.
+            std::optional<T> pop() {
+                std::unique_lock<std::mutex> lock(mtx_);
+                while (items_.empty() && !closed_) {
+                    not_empty_.wait(lock);
+                    wakeups_.fetch_add(1, std::memory_order_relaxed);
+                    if (items_.empty() && !closed_) {
+                        idle_wakeups_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (items_.empty()) return std::nullopt;
+                T item = std::move(items_.front());
+                items_.pop_front();
+                lock.unlock();
+                not_full_.notify_one();
+                return item;
+            }
+
+            // Wakes every waiter; pending items can still be popped.
+            void close() {
+                {
+                    std::lock_guard<std::mutex> lock(mtx_);
+                    closed_ = true;
+                }
+                not_empty_.notify_all();
+                not_full_.notify_all();
+            }
+
+            size_t size() const {
+                std::lock_guard<std::mutex> lock(mtx_);
+                return items_.size();
+            }
+
+            size_t capacity() const { return capacity_; }
+
+            // Times a consumer was woken while waiting, and how many of those
+            // wakeups found no work (spurious wakeups).
+            uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+            uint64_t idle_wakeups() const { return idle_wakeups_.load(std::memory_order_relaxed); }
+
+        private:
+            const size_t capacity_;
+            mutable std::mutex mtx_;
+            std::condition_variable not_empty_;
+            std::condition_variable not_full_;
+            std::deque<T> items_;
+            bool closed_ = false;
+
+            std::atomic<uint64_t> wakeups_{0};
+            std::atomic<uint64_t> idle_wakeups_{0};
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_BOUNDEDQUEUE_H
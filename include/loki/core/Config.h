@@ -19,8 +19,17 @@ namespace loki {
             // Gets a float value for a given key.
             float get_float(const std::string &key, float default_value = 0.0f) const;
 
+            // Gets a file path for a given key. Relative paths are resolved against
+            // the base directory; an empty value stays empty.
+            std::string get_path(const std::string &key, const std::string &default_value = "") const;
+
+            // Directory get_path() resolves relative paths against. Empty (the
+            // default) leaves them relative to the working directory.
+            void set_base_dir(const std::string &dir) { base_dir = dir; }
+
         private:
             std::map<std::string, std::string> data;
+            std::string base_dir;
         };
     } // namespace core
 } // namespace loki
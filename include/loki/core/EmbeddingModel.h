@@ -1,6 +1,7 @@
 #ifndef LOKI_EMBEDDINGMODEL_H
 #define LOKI_EMBEDDINGMODEL_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -16,6 +17,16 @@ public:
 
     std::vector<float> get_embeddings(const std::string &text);
 
+    // Embeds many texts with as few llama_encode calls as possible by packing
+    // them into one batch, one sequence id per text. The result has one entry
+    // per input, in order; an entry is empty if that text failed to embed.
+    // Uses a larger context created for the call and freed afterwards.
+    std::vector<std::vector<float> > get_embeddings_batch(const std::vector<std::string> &texts);
+
+    // FNV-1a hash of the loaded GGUF file, computed on first use. Anything
+    // persisted from this model's output should be keyed by it. 0 if not loaded.
+    uint64_t model_hash() const;
+
     // A modern C++ way to create an instance
     static std::unique_ptr<EmbeddingModel> create(const std::string &model_path);
 
@@ -0,0 +1,122 @@
+#ifndef LOKI_ENDPOINTER_H
+#define LOKI_ENDPOINTER_H
+
+#include "loki/core/Config.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct whisper_vad_context;
+
+namespace loki {
+    namespace core {
+        struct EndpointerOptions {
+            int sample_rate = 16000;
+            int hangover_ms = 1280; // Trailing silence after speech that ends the command
+            int no_speech_timeout_ms = 3200; // Give up if nobody starts speaking
+            int speech_pad_ms = 200; // Kept around detected speech when trimming
+            float threshold = 0.01f; // Backend-specific: RMS level or speech probability
+        };
+
+        // Decides when a spoken command has ended. Subclasses only classify
+        // individual frames as speech / non-speech; the hangover, timeout and
+        // trimming logic is shared.
+        class Endpointer {
+        public:
+            explicit Endpointer(const EndpointerOptions &options);
+
+            // Builds the endpointer the VAD_* keys describe: Silero if VAD_BACKEND is
+            // "silero" and its model loads, otherwise RMS with RMS defaults.
+            static std::unique_ptr<Endpointer> create(const Config &config, int sample_rate);
+
+            virtual ~Endpointer() = default;
+
+            virtual std::string get_name() const = 0;
+
+            // Start a new command. `initial_samples` is audio already in the command
+            // buffer (the pre-roll) that is not analyzed.
+            void reset(size_t initial_samples = 0);
+
+            // Feed the next captured frame. Returns true once the command has ended.
+            bool process(const float *samples, size_t n_samples);
+
+            bool has_speech() const { return has_speech_; }
+
+            const EndpointerOptions &options() const { return options_; }
+
+            // Cuts leading/trailing non-speech from a finished command buffer, keeping
+            // `speech_pad_ms` around it. The pre-roll is kept if speech runs into it.
+            void trim(std::vector<float> &audio) const;
+
+            // The [start, end) range trim() would keep of an `n_samples` long command
+            // buffer. Returns false if nothing would be cut.
+            bool trim_bounds(size_t n_samples, size_t &start, size_t &end) const;
+
+        protected:
+            // Returns true if this frame contains speech.
+            virtual bool is_speech(const float *samples, size_t n_samples) = 0;
+
+            virtual void on_reset() {
+            }
+
+            // How far behind the audio is_speech() decisions can be, in samples.
+            // Speech is detected late by up to this much, so trimming starts earlier.
+            virtual size_t decision_delay() const { return 0; }
+
+            const EndpointerOptions options_;
+
+        private:
+            size_t initial_samples_ = 0;
+            size_t position_ = 0; // Samples seen, including the pre-roll
+            size_t speech_start_ = 0;
+            size_t speech_end_ = 0;
+            bool has_speech_ = false;
+        };
+
+        // The original endpointer: a frame is speech if its RMS exceeds the threshold.
+        class RmsEndpointer : public Endpointer {
+        public:
+            using Endpointer::Endpointer;
+
+            std::string get_name() const override { return "rms"; }
+
+        protected:
+            bool is_speech(const float *samples, size_t n_samples) override;
+        };
+
+        // Runs whisper.cpp's Silero VAD once per `context_ms` of captured audio and
+        // treats the newest window's speech probability as the decision for the
+        // frames until the next run. The VAD API keeps no state between calls, so
+        // this is the cheapest way to give every run the same warm-up.
+        class SileroEndpointer : public Endpointer {
+        public:
+            // Returns nullptr if the VAD model cannot be loaded.
+            static std::unique_ptr<SileroEndpointer> create(const std::string &model_path,
+                                                            const EndpointerOptions &options,
+                                                            int context_ms = 192);
+
+            ~SileroEndpointer() override;
+
+            std::string get_name() const override { return "silero"; }
+
+        protected:
+            bool is_speech(const float *samples, size_t n_samples) override;
+
+            void on_reset() override;
+
+            size_t decision_delay() const override { return context_samples_; }
+
+        private:
+            SileroEndpointer(whisper_vad_context *vctx, const EndpointerOptions &options, size_t context_samples);
+
+            whisper_vad_context *vctx_ = nullptr;
+            std::vector<float> context_; // Audio since the last VAD run, oldest first
+            const size_t context_samples_;
+            bool speech_ = false; // Decision of the last VAD run
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_ENDPOINTER_H
@@ -0,0 +1,29 @@
+#ifndef LOKI_HASH_H
+#define LOKI_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace loki {
+    namespace core {
+        constexpr uint64_t FNV1A_64_OFFSET = 14695981039346656037ull;
+        constexpr uint64_t FNV1A_64_PRIME = 1099511628211ull;
+
+        // 64-bit FNV-1a. Pass the previous result as `hash` to hash data in pieces.
+        inline uint64_t fnv1a_64(const void *data, size_t size, uint64_t hash = FNV1A_64_OFFSET) {
+            const auto *bytes = static_cast<const unsigned char *>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= bytes[i];
+                hash *= FNV1A_64_PRIME;
+            }
+            return hash;
+        }
+
+        inline uint64_t fnv1a_64(const std::string &text) {
+            return fnv1a_64(text.data(), text.size());
+        }
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_HASH_H
@@ -0,0 +1,152 @@
+#ifndef LOKI_ILLMBACKEND_H
+#define LOKI_ILLMBACKEND_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace loki {
+    namespace core {
+        struct GenerateMetrics {
+            double first_token_ms = -1.0; // Request start -> first generated text; -1 if none
+            double json_complete_ms = -1.0; // Request start -> balanced JSON object; -1 if not seen
+            double total_ms = 0.0; // Until generation ended or was aborted
+            size_t chunks = 0; // Streamed pieces (tokens for the in-process backend)
+            bool stopped_early = false; // Aborted after the JSON object, before the model was done
+            bool constrained = false; // Decoded under an OutputFormat
+            int prompt_tokens = -1; // Whole formatted prompt; -1 if the backend doesn't say
+            int prompt_tokens_evaluated = -1; // Prompt tokens actually run through the model, not reused from the KV cache
+            bool prompt_prefix_lost = false; // The cached prefix had been dropped by a decode error and was evaluated again
+            double prompt_eval_ms = -1.0; // Time spent on those tokens; -1 if unknown
+        };
+
+        struct GenerateStats {
+            uint64_t requests = 0;
+            uint64_t stopped_early = 0;
+            uint64_t constrained = 0;
+            uint64_t first_tokens = 0; // Requests that produced any output
+            uint64_t json_completed = 0; // Requests whose output contained a complete JSON object
+            double first_token_ms_total = 0.0; // Divide by first_tokens for the mean
+            double json_complete_ms_total = 0.0; // Divide by json_completed for the mean
+            uint64_t prompt_evals = 0; // Requests that reported prompt evaluation
+            uint64_t prompt_tokens_total = 0;
+            uint64_t prompt_tokens_evaluated_total = 0;
+            uint64_t prompt_prefix_losses = 0; // Requests with prompt_prefix_lost set
+            double prompt_eval_ms_total = 0.0; // Divide by prompt_evals for the mean
+        };
+
+        // Restricts what the model may emit. Each backend uses the form it
+        // understands: llama.cpp samples under the GBNF grammar, Ollama gets the
+        // JSON schema in its "format" field. Both should describe the same language.
+        struct OutputFormat {
+            std::string gbnf; // Start symbol "root"
+            std::string json_schema; // Serialized JSON Schema
+        };
+
+        // A text generator the intent classifier can run prompts through: the
+        // Ollama server (OllamaClient) or a model loaded in-process (LlamaBackend).
+        // Implementations only provide generate_impl(); the public overloads and
+        // the metrics bookkeeping are shared.
+        class ILLMBackend {
+        public:
+            virtual ~ILLMBackend() = default;
+
+            virtual std::string get_name() const = 0;
+
+            // Runs one prompt and returns the whole response.
+            std::string generate(const std::string &system_prompt, const std::string &user_prompt) {
+                return generate_impl(system_prompt, user_prompt, nullptr, false, nullptr);
+            }
+
+            // Same, but abandons generation once `cancelled` is set and returns "".
+            std::string generate(const std::string &system_prompt, const std::string &user_prompt,
+                                 const std::atomic<bool> &cancelled) {
+                return generate_impl(system_prompt, user_prompt, &cancelled, false, nullptr);
+            }
+
+            // For prompts that must answer with one JSON object: stops generating
+            // as soon as the first balanced {...} is out and returns the text up
+            // to its '}'.
+            std::string generate_json(const std::string &system_prompt, const std::string &user_prompt) {
+                return generate_impl(system_prompt, user_prompt, nullptr, true, nullptr);
+            }
+
+            std::string generate_json(const std::string &system_prompt, const std::string &user_prompt,
+                                      const std::atomic<bool> &cancelled) {
+                return generate_impl(system_prompt, user_prompt, &cancelled, true, nullptr);
+            }
+
+            // Same, with decoding constrained to `format` so the answer always parses.
+            std::string generate_json(const std::string &system_prompt, const std::string &user_prompt,
+                                      const OutputFormat &format) {
+                return generate_impl(system_prompt, user_prompt, nullptr, true, &format);
+            }
+
+            std::string generate_json(const std::string &system_prompt, const std::string &user_prompt,
+                                      const OutputFormat &format, const std::atomic<bool> &cancelled) {
+                return generate_impl(system_prompt, user_prompt, &cancelled, true, &format);
+            }
+
+            // Prepares for requests that start with `system_prompt`, e.g. by
+            // evaluating it into the KV cache ahead of time. Optional.
+            virtual void prefill(const std::string &/*system_prompt*/) {
+            }
+
+            // Interrupts the generation in flight, if any, as soon as possible.
+            // Callers should also set their `cancelled` flag. Safe from any thread.
+            virtual void cancel() = 0;
+
+            // Metrics of the most recent finished request, and running totals.
+            GenerateMetrics last_metrics() const {
+                std::lock_guard<std::mutex> lock(metrics_mtx_);
+                return last_metrics_;
+            }
+
+            GenerateStats stats() const {
+                std::lock_guard<std::mutex> lock(metrics_mtx_);
+                return stats_;
+            }
+
+        protected:
+            // `cancelled` and `format` may be null.
+            virtual std::string generate_impl(const std::string &system_prompt, const std::string &user_prompt,
+                                              const std::atomic<bool> *cancelled, bool stop_after_json,
+                                              const OutputFormat *format) = 0;
+
+            // Implementations call this once per finished (not cancelled) request.
+            void record_metrics(const GenerateMetrics &metrics) {
+                std::lock_guard<std::mutex> lock(metrics_mtx_);
+                last_metrics_ = metrics;
+                stats_.requests++;
+                stats_.stopped_early += metrics.stopped_early;
+                stats_.constrained += metrics.constrained;
+                if (metrics.first_token_ms >= 0.0) {
+                    stats_.first_token_ms_total += metrics.first_token_ms;
+                    stats_.first_tokens++;
+                }
+                if (metrics.json_complete_ms >= 0.0) {
+                    stats_.json_complete_ms_total += metrics.json_complete_ms;
+                    stats_.json_completed++;
+                }
+                if (metrics.prompt_eval_ms >= 0.0) {
+                    stats_.prompt_evals++;
+                    stats_.prompt_eval_ms_total += metrics.prompt_eval_ms;
+                    if (metrics.prompt_tokens > 0) stats_.prompt_tokens_total += metrics.prompt_tokens;
+                    if (metrics.prompt_tokens_evaluated > 0) {
+                        stats_.prompt_tokens_evaluated_total += metrics.prompt_tokens_evaluated;
+                    }
+                    stats_.prompt_prefix_losses += metrics.prompt_prefix_lost;
+                }
+            }
+
+        private:
+            mutable std::mutex metrics_mtx_;
+            GenerateMetrics last_metrics_;
+            GenerateStats stats_;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_ILLMBACKEND_H
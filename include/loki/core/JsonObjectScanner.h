@@ -0,0 +1,46 @@
+#ifndef LOKI_JSONOBJECTSCANNER_H
+#define LOKI_JSONOBJECTSCANNER_H
+
+#include <cstddef>
+#include <string>
+
+namespace loki {
+    namespace core {
+        // Follows the brace depth of streamed text, skipping braces inside JSON
+        // strings, to tell when the first top-level object is complete. Text
+        // before the first '{' is ignored.
+        class JsonObjectScanner {
+        public:
+            // Feeds more text. Returns the offset just past the closing '}' of
+            // the first object within `text`, or npos if it isn't complete yet.
+            size_t feed(const std::string &text) {
+                for (size_t i = 0; i < text.size(); ++i) {
+                    const char c = text[i];
+                    if (depth_ == 0) {
+                        if (c == '{') depth_ = 1;
+                        continue;
+                    }
+                    if (in_string_) {
+                        if (escaped_) escaped_ = false;
+                        else if (c == '\\') escaped_ = true;
+                        else if (c == '"') in_string_ = false;
+                    } else if (c == '"') {
+                        in_string_ = true;
+                    } else if (c == '{') {
+                        depth_++;
+                    } else if (c == '}' && --depth_ == 0) {
+                        return i + 1;
+                    }
+                }
+                return std::string::npos;
+            }
+
+        private:
+            int depth_ = 0;
+            bool in_string_ = false;
+            bool escaped_ = false;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_JSONOBJECTSCANNER_H
@@ -0,0 +1,65 @@
+#ifndef LOKI_LLAMABACKEND_H
+#define LOKI_LLAMABACKEND_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "loki/core/Config.h"
+#include "loki/core/ILLMBackend.h"
+
+namespace loki {
+    namespace core {
+        struct LlamaBackendOptions {
+            uint32_t n_ctx = 2048; // Prompt + answer must fit
+            uint32_t n_batch = 512; // Prompt tokens decoded per llama_decode call
+            int n_threads = 0; // 0 = half the hardware threads, at most 8
+            int n_gpu_layers = 0;
+            int max_tokens = 128; // Hard cap on generated tokens per request
+            bool reuse_prefix = true; // Keep the last prompt in the KV cache and only evaluate what changed
+
+            // Reads LLM_THREADS, LLM_GPU_LAYERS and LLM_PROMPT_CACHE. n_ctx and
+            // max_tokens follow the request options shared with Ollama, so callers set them.
+            static LlamaBackendOptions from_config(const Config &config);
+        };
+
+        // Runs an instruct GGUF model in-process through llama.cpp, so intent
+        // classification needs no Ollama server and no HTTP round trip.
+        //
+        // The model and one context are loaded once and kept warm. Prompts are
+        // formatted with the model's own chat template and decoded greedily, which
+        // matches the temperature 0 / top_k 1 settings used with Ollama. The KV
+        // entries of the previous prompt are kept, so a request that shares its
+        // system prompt with the last one only evaluates the new user turn.
+        // Requests are serialized: the context is not thread-safe.
+        class LlamaBackend : public ILLMBackend {
+        public:
+            static std::unique_ptr<LlamaBackend> create(const std::string &model_path,
+                                                        const LlamaBackendOptions &options);
+
+            ~LlamaBackend() override;
+
+            std::string get_name() const override { return "llama"; }
+
+            // Evaluates the system prompt into the KV cache so the first request
+            // only pays for its user turn.
+            void prefill(const std::string &system_prompt) override;
+
+            // Aborts the generation in flight, including a prompt still being decoded.
+            void cancel() override;
+
+        protected:
+            std::string generate_impl(const std::string &system_prompt, const std::string &user_prompt,
+                                      const std::atomic<bool> *cancelled, bool stop_after_json,
+                                      const OutputFormat *format) override;
+
+        private:
+            LlamaBackend();
+
+            struct LlamaBackendImpl;
+            std::unique_ptr<LlamaBackendImpl> pimpl_;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_LLAMABACKEND_H
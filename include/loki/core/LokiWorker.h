@@ -1,26 +1,38 @@
 #pragma once
 
 #include <QObject>
-#include <QTimer>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Forward declarations
 struct ma_device;
 struct AppData;
-struct pv_porcupine;
-typedef struct pv_porcupine pv_porcupine_t;
+struct CapturedUtterance;
 
 namespace loki {
     namespace core {
         class Config;
-        class OllamaClient;
+        class ILLMBackend;
+        class AudioRingBuffer;
+        template<typename In>
+        class PipelineStage;
+        struct PipelineStageStats;
+        class StreamingTranscriber;
+        class Endpointer;
+        class WakeWordDetector;
     }
 
     namespace intent {
         class FastClassifier;
         class IntentClassifier;
+        class SemanticIntentCache;
+        struct Intent;
     }
 
     namespace tts {
@@ -58,8 +70,8 @@ public:
 
     void play_audio_from_memory(const std::vector<char> &audioData);
 
-public slots:
-    void check_for_command();
+    // Queue depth and occupancy of each command pipeline stage.
+    std::vector<loki::core::PipelineStageStats> pipeline_stats() const;
 
 signals:
     void status_updated(const QString &status);
@@ -71,26 +83,76 @@ signals:
     void wake_word_detected_signal();
 
 private:
+    // Dedicated wake word thread: drains the capture ring in Porcupine-sized
+    // frames and runs the wake word / recording state machine.
+    void audio_thread_loop();
+
+    // Command pipeline stage handlers: STT -> intent -> agent -> TTS.
+    // Each runs on its own stage thread and submits into the next stage.
+    void run_transcription(CapturedUtterance utterance);
+
+    // Streaming thread: shows partial hypotheses and pre-classifies them.
+    void on_partial_transcript(const std::string &partial);
+
+    void run_intent(std::string transcription);
+
+    void run_agent(loki::intent::Intent intent);
+
+    void run_speech(std::string text);
+
+    void log_pipeline_stats() const;
+
     // Configuration and core components
     std::unique_ptr<loki::core::Config> config_;
     std::unique_ptr<AppData> app_data_;
     std::unique_ptr<ma_device> device_;
-    QTimer *processing_timer_;
+
+    // Audio capture: the device callback only writes into the ring,
+    // everything else happens on audio_thread_.
+    std::unique_ptr<loki::core::AudioRingBuffer> capture_ring_;
+    std::thread audio_thread_;
+    std::atomic<bool> audio_thread_running_{false};
+    // Longest audio_thread_ sleeps on the capture ring before rechecking its flag.
+    static constexpr int AUDIO_WAIT_TIMEOUT_MS = 500;
+    // Times audio_thread_ waited on the capture ring, and how many of those
+    // woke without a full frame. Only touched by audio_thread_ until it is joined.
+    uint64_t audio_wakeups_ = 0;
+    uint64_t audio_idle_wakeups_ = 0;
+    std::unique_ptr<loki::core::Endpointer> endpointer_;
+
+    // Command pipeline. End-of-speech submits straight into transcription_stage_.
+    static constexpr size_t STAGE_QUEUE_CAPACITY = 4;
+    static constexpr int SPEECH_SYNTHESIS_TIMEOUT_MS = 15000;
+    std::unique_ptr<loki::core::PipelineStage<CapturedUtterance> > transcription_stage_;
+    std::unique_ptr<loki::core::PipelineStage<std::string> > intent_stage_;
+    std::unique_ptr<loki::core::PipelineStage<loki::intent::Intent> > agent_stage_;
+    std::unique_ptr<loki::core::PipelineStage<std::string> > speech_stage_;
+    std::chrono::steady_clock::time_point processing_started_;
+    int whisper_states_ = 1;
 
     // AI/ML components
     std::unique_ptr<Whisper> whisper_;
+    std::unique_ptr<loki::core::StreamingTranscriber> streaming_; // Only with STREAMING_STT=1
     std::unique_ptr<EmbeddingModel> embedding_model_;
     std::unique_ptr<loki::intent::FastClassifier> fast_classifier_;
-    std::unique_ptr<loki::core::OllamaClient> ollama_client_;
+    std::unique_ptr<loki::core::ILLMBackend> llm_backend_; // Ollama or in-process llama.cpp (LLM_BACKEND)
     std::unique_ptr<loki::intent::IntentClassifier> llm_classifier_;
+    std::unique_ptr<loki::intent::SemanticIntentCache> semantic_cache_; // Null with LLM_CACHE_SIZE=0
     std::unique_ptr<AgentManager> agent_manager_;
 
     // TTS system - UPDATED to use AsyncTTSManager
     std::unique_ptr<loki::tts::AsyncTTSManager> async_tts_;
 
     // Wake word detection
-    pv_porcupine_t *porcupine_ = nullptr;
+    std::unique_ptr<loki::core::WakeWordDetector> wake_word_;
+
+    // Fast-path result for the latest partial transcript, reused by run_intent
+    // when the final transcript matches it.
+    std::mutex early_intent_mtx_;
+    std::string early_intent_text_;
+    std::shared_ptr<const loki::intent::Intent> early_intent_;
 
     // Configuration parameters
     int min_command_ms_ = 300;
+    bool speculative_llm_ = false; // LLM_SPECULATIVE: start the LLM alongside the embedding search
 };
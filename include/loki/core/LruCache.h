@@ -0,0 +1,96 @@
+#ifndef LOKI_LRUCACHE_H
+#define LOKI_LRUCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace loki {
+    namespace core {
+        struct LruCacheStats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            size_t size = 0;
+            size_t capacity = 0;
+        };
+
+        // A bounded, thread-safe least-recently-used map. Values are copied in
+        // and out under one mutex, so keep them small or cheap to copy.
+        // A capacity of 0 disables the cache: get() always misses, put() is a no-op.
+        template<typename K, typename V, typename Hash = std::hash<K> >
+        class LruCache {
+        public:
+            explicit LruCache(size_t capacity) : capacity_(capacity) {
+            }
+
+            // Copies the value for `key` into `out` and marks it most recently used.
+            bool get(const K &key, V &out) {
+                if (capacity_ == 0) return false;
+                std::lock_guard<std::mutex> lock(mtx_);
+                auto it = index_.find(key);
+                if (it == index_.end()) {
+                    misses_++;
+                    return false;
+                }
+                entries_.splice(entries_.begin(), entries_, it->second);
+                out = it->second->second;
+                hits_++;
+                return true;
+            }
+
+            // Inserts or replaces `key`, evicting the least recently used entry if full.
+            void put(const K &key, V value) {
+                if (capacity_ == 0) return;
+                std::lock_guard<std::mutex> lock(mtx_);
+                auto it = index_.find(key);
+                if (it != index_.end()) {
+                    it->second->second = std::move(value);
+                    entries_.splice(entries_.begin(), entries_, it->second);
+                    return;
+                }
+                if (entries_.size() >= capacity_) {
+                    index_.erase(entries_.back().first);
+                    entries_.pop_back();
+                    evictions_++;
+                }
+                entries_.emplace_front(key, std::move(value));
+                index_.emplace(key, entries_.begin());
+            }
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mtx_);
+                index_.clear();
+                entries_.clear();
+            }
+
+            LruCacheStats stats() const {
+                std::lock_guard<std::mutex> lock(mtx_);
+                LruCacheStats s;
+                s.hits = hits_;
+                s.misses = misses_;
+                s.evictions = evictions_;
+                s.size = entries_.size();
+                s.capacity = capacity_;
+                return s;
+            }
+
+        private:
+            using Entry = std::pair<K, V>;
+
+            const size_t capacity_;
+            mutable std::mutex mtx_;
+            std::list<Entry> entries_; // Most recently used first
+            std::unordered_map<K, typename std::list<Entry>::iterator, Hash> index_;
+            uint64_t hits_ = 0;
+            uint64_t misses_ = 0;
+            uint64_t evictions_ = 0;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_LRUCACHE_H
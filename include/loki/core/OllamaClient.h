@@ -1,9 +1,11 @@
 #ifndef LOKI_OLLAMACLIENT_H
 #define LOKI_OLLAMACLIENT_H
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include "nlohmann/json.hpp" // NEW: Include the json header
+#include "loki/core/ILLMBackend.h"
 
 // Forward declare to hide implementation details (httplib::Client) from the header
 namespace httplib {
@@ -12,21 +14,41 @@ namespace httplib {
 
 namespace loki {
     namespace core {
-        class OllamaClient {
+        class OllamaClient : public ILLMBackend {
         public:
             // MODIFIED: Add a new constructor that accepts performance options.
             // The default empty json object makes it backwards compatible.
-            OllamaClient(const std::string &host, const std::string &model_name, const nlohmann::json &options = {});
+            // `keep_alive` ("30m", "-1", ...) keeps the model loaded between requests so
+            // Ollama can reuse the cached system-prompt prefix; empty uses the server default.
+            OllamaClient(const std::string &host, const std::string &model_name, const nlohmann::json &options = {},
+                         const std::string &keep_alive = "");
 
             // Destructor is required for the PIMPL-lite pattern with unique_ptr
             ~OllamaClient();
 
-            // Sends a prompt to the Ollama model and returns the response.
-            std::string generate(const std::string &system_prompt, const std::string &user_prompt);
+            std::string get_name() const override { return "ollama"; }
+
+            // Shuts down the connection of the request in flight, if any. Safe to
+            // call from any thread; Ollama stops generating when the client goes away.
+            void cancel() override;
+
+        protected:
+            // Streams the response as NDJSON and assembles it as it arrives. The
+            // cancel flag is checked between chunks; cancel() also interrupts a
+            // request still waiting for its first token. Prompt evaluation metrics
+            // come from the final chunk, so they are missing when the stream is cut
+            // short after the JSON object.
+            std::string generate_impl(const std::string &system_prompt, const std::string &user_prompt,
+                                      const std::atomic<bool> *cancelled, bool stop_after_json,
+                                      const OutputFormat *format) override;
 
         private:
+            nlohmann::json make_payload(const std::string &system_prompt, const std::string &user_prompt,
+                                        const OutputFormat *format) const;
+
             std::string model_name_;
             nlohmann::json options_; // NEW: Member variable to store the options
+            std::string keep_alive_;
             std::unique_ptr<httplib::Client> client_;
         };
     } // namespace core
@@ -0,0 +1,119 @@
+#ifndef LOKI_PIPELINESTAGE_H
+#define LOKI_PIPELINESTAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loki/core/BoundedQueue.h"
+
+namespace loki {
+    namespace core {
+        // A point-in-time view of one stage, for logging and the UI.
+        struct PipelineStageStats {
+            std::string name;
+            size_t queue_depth = 0;
+            size_t queue_capacity = 0;
+            size_t busy_workers = 0; // Occupancy: workers currently inside the handler
+            size_t workers = 0;
+            uint64_t processed = 0;
+            double busy_ms = 0.0; // Total time spent inside the handler
+            uint64_t wakeups = 0;
+            uint64_t idle_wakeups = 0;
+        };
+
+        // One stage of the command pipeline: a bounded input queue drained by a
+        // fixed number of worker threads that run `handler` on each item.
+        // Stages are chained by having a handler submit() into the next stage,
+        // so a full downstream queue applies backpressure upstream.
+        template<typename In>
+        class PipelineStage {
+        public:
+            using Handler = std::function<void(In)>;
+
+            PipelineStage(std::string name, size_t queue_capacity, size_t workers, Handler handler)
+                : name_(std::move(name)), queue_(queue_capacity), n_workers_(workers == 0 ? 1 : workers),
+                  handler_(std::move(handler)) {
+            }
+
+            ~PipelineStage() {
+                stop();
+            }
+
+            PipelineStage(const PipelineStage &) = delete;
+
+            PipelineStage &operator=(const PipelineStage &) = delete;
+
+            void start() {
+                for (size_t i = 0; i < n_workers_; ++i) {
+                    threads_.emplace_back(&PipelineStage::worker_loop, this);
+                }
+            }
+
+            // Blocks while the stage's queue is full. Returns false once stopped.
+            bool submit(In item) { return queue_.push(std::move(item)); }
+
+            // Never blocks. Returns false if the queue is full or the stage is stopped.
+            bool try_submit(In item) { return queue_.try_push(std::move(item)); }
+
+            // Lets the workers drain what is already queued, then joins them.
+            void stop() {
+                queue_.close();
+                for (auto &t: threads_) {
+                    if (t.joinable()) t.join();
+                }
+                threads_.clear();
+            }
+
+            PipelineStageStats stats() const {
+                PipelineStageStats s;
+                s.name = name_;
+                s.queue_depth = queue_.size();
+                s.queue_capacity = queue_.capacity();
+                s.busy_workers = busy_.load(std::memory_order_relaxed);
+                s.workers = n_workers_;
+                s.processed = processed_.load(std::memory_order_relaxed);
+                s.busy_ms = busy_us_.load(std::memory_order_relaxed) / 1000.0;
+                s.wakeups = queue_.wakeups();
+                s.idle_wakeups = queue_.idle_wakeups();
+                return s;
+            }
+
+        private:
+            void worker_loop() {
+                while (auto item = queue_.pop()) {
+                    busy_.fetch_add(1, std::memory_order_relaxed);
+                    const auto start = std::chrono::steady_clock::now();
+                    try {
+                        handler_(std::move(*item));
+                    } catch (const std::exception &e) {
+                        std::cerr << "ERROR: Pipeline stage '" << name_ << "' failed: " << e.what() << std::endl;
+                    }
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                    busy_us_.fetch_add(static_cast<uint64_t>(elapsed), std::memory_order_relaxed);
+                    processed_.fetch_add(1, std::memory_order_relaxed);
+                    busy_.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+
+            const std::string name_;
+            BoundedQueue<In> queue_;
+            const size_t n_workers_;
+            Handler handler_;
+            std::vector<std::thread> threads_;
+
+            std::atomic<size_t> busy_{0};
+            std::atomic<uint64_t> processed_{0};
+            std::atomic<uint64_t> busy_us_{0};
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_PIPELINESTAGE_H
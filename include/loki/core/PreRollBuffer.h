@@ -0,0 +1,34 @@
+#ifndef LOKI_PREROLLBUFFER_H
+#define LOKI_PREROLLBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace loki {
+    namespace core {
+        // Fixed-size circular history of the most recent capture audio.
+        // It is fed every frame while listening so that audio spoken together
+        // with (or just before) the wake word can be prepended to the command.
+        // Not thread-safe; owned by the audio thread.
+        class PreRollBuffer {
+        public:
+            explicit PreRollBuffer(size_t capacity_frames = 0);
+
+            void push(const float *frames, size_t count);
+
+            // Appends the buffered history, oldest sample first, to `out`.
+            void copy_to(std::vector<float> &out) const;
+
+            size_t size() const { return size_; }
+
+            void clear();
+
+        private:
+            std::vector<float> buffer_;
+            size_t write_pos_ = 0;
+            size_t size_ = 0;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_PREROLLBUFFER_H
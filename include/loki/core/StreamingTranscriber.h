@@ -0,0 +1,108 @@
+#ifndef LOKI_STREAMINGTRANSCRIBER_H
+#define LOKI_STREAMINGTRANSCRIBER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loki/core/Whisper.h"
+
+namespace loki {
+    namespace core {
+        // Re-decodes the command audio in the background while the user is still
+        // speaking, using its own whisper_state so it never blocks the regular
+        // transcription path.
+        //
+        // Each partial decode covers the audio from the last commit point to the
+        // end of what has been captured. Once that span grows past the window
+        // length, every segment except the last one is committed (its text is
+        // frozen and the commit point moves to its end time). The final decode in
+        // finish() therefore only has to cover the last, uncommitted window - and
+        // is skipped entirely if the latest partial already covered all audio.
+        class StreamingTranscriber {
+        public:
+            struct Options {
+                int sample_rate = 16000;
+                int step_ms = 1000; // Minimum new audio before another partial decode
+                int window_ms = 8000; // Uncommitted span after which segments are committed
+            };
+
+            // Per-utterance streaming state. Created by begin() on the audio thread
+            // and later handed to finish() by the transcription stage.
+            class Session {
+            private:
+                friend class StreamingTranscriber;
+                std::vector<float> audio;
+                size_t committed_samples = 0;
+                std::string committed_text;
+                size_t decoded_samples = 0; // Audio covered by `partial_text`
+                std::string partial_text;
+                bool ended = false;
+            };
+
+            struct Stats {
+                uint64_t partial_decodes = 0;
+                uint64_t final_decodes = 0;
+                uint64_t final_decodes_skipped = 0; // The last partial already covered everything
+                double last_final_ms = 0.0;
+            };
+
+            // Called on the streaming thread with the best transcript so far.
+            using PartialCallback = std::function<void(const std::string &text)>;
+
+            // Returns nullptr if a decoder state cannot be allocated.
+            static std::unique_ptr<StreamingTranscriber> create(Whisper &whisper, const Options &options,
+                                                                PartialCallback on_partial);
+
+            ~StreamingTranscriber();
+
+            // Audio thread: start a new utterance, append to it, and mark it complete.
+            std::shared_ptr<Session> begin();
+
+            void feed(const std::shared_ptr<Session> &session, const float *samples, size_t n_samples);
+
+            void end(const std::shared_ptr<Session> &session);
+
+            // Audio thread: limit the session to samples [start, end), as the endpointer
+            // trims the command buffer. Leading audio is skipped rather than erased, so
+            // sample offsets of committed segments stay valid.
+            void clip(const std::shared_ptr<Session> &session, size_t start, size_t end);
+
+            // Transcription stage: returns the full transcript of an ended session,
+            // decoding only the audio after its last commit point.
+            std::string finish(const std::shared_ptr<Session> &session);
+
+            Stats stats() const;
+
+        private:
+            StreamingTranscriber(Whisper &whisper, Whisper::StatePtr state, const Options &options,
+                                 PartialCallback on_partial);
+
+            void worker_loop();
+
+            // Decodes session audio from its commit point onwards. Must hold decode_mtx_.
+            std::vector<Whisper::Segment> decode_tail(const std::vector<float> &audio, size_t from);
+
+            Whisper &whisper_;
+            Whisper::StatePtr state_;
+            std::mutex decode_mtx_; // Serializes use of state_
+            const Options options_;
+            PartialCallback on_partial_;
+
+            mutable std::mutex mtx_;
+            std::condition_variable cv_;
+            std::shared_ptr<Session> active_; // Session partials are being produced for
+            bool running_ = true;
+            Stats stats_;
+            std::thread thread_;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_STREAMINGTRANSCRIBER_H
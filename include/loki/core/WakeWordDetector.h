@@ -0,0 +1,64 @@
+#ifndef LOKI_WAKEWORDDETECTOR_H
+#define LOKI_WAKEWORDDETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct pv_porcupine;
+typedef struct pv_porcupine pv_porcupine_t;
+
+namespace loki {
+    namespace core {
+        // Wraps Porcupine so it can be driven from LokiWorker's audio thread
+        // instead of the real-time capture callback. Frames are fed in fixed
+        // pv_porcupine_frame_length() chunks; the int16 conversion buffer is
+        // allocated once.
+        class WakeWordDetector {
+        public:
+            struct Stats {
+                uint64_t frames_processed = 0;
+                uint64_t detections = 0;
+                double last_latency_ms = 0.0; // Capture-to-detection latency of the last detection
+                double max_process_ms = 0.0; // Slowest single pv_porcupine_process call
+                size_t last_backlog_frames = 0; // Frames still queued when the last detection happened
+                size_t max_backlog_frames = 0;
+            };
+
+            // Returns nullptr and fills `error` if Porcupine fails to initialize.
+            static std::unique_ptr<WakeWordDetector> create(const std::string &access_key,
+                                                            const std::string &model_path,
+                                                            const std::string &keyword_path,
+                                                            float sensitivity,
+                                                            std::string &error);
+
+            ~WakeWordDetector();
+
+            size_t frame_length() const { return pcm_.size(); }
+
+            int sample_rate() const;
+
+            // Processes exactly frame_length() samples of 32-bit float audio.
+            // `backlog_frames` is how much audio was still waiting in the capture
+            // ring behind this frame; it is used for the latency/backlog stats.
+            // Returns true if the wake word was detected.
+            bool process(const float *frame, size_t backlog_frames);
+
+            Stats stats() const;
+
+        private:
+            explicit WakeWordDetector(pv_porcupine_t *porcupine);
+
+            pv_porcupine_t *porcupine_ = nullptr;
+            std::vector<int16_t> pcm_;
+
+            mutable std::mutex stats_mtx_;
+            Stats stats_;
+        };
+    } // namespace core
+} // namespace loki
+
+#endif //LOKI_WAKEWORDDETECTOR_H
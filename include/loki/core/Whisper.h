@@ -5,16 +5,74 @@
 #include <cstdint>
 #include <vector>
 #include <memory> // ADDED for std::unique_ptr
+#include <cstddef>
+
+struct whisper_state;
 
 // This is our C++ wrapper class for the whisper.cpp C-style API.
 // It uses the "PIMPL" (Pointer to Implementation) idiom to hide
 // the underlying C-API details from the rest of our application.
+//
+// The model weights are loaded once; decoding happens on a fixed pool of
+// whisper_state objects, so up to `n_states` transcriptions can run in
+// parallel without loading a second copy of the model.
 
 class Whisper {
 public:
+    // A transcribed piece of audio with timestamps relative to the start of the input.
+    struct Segment {
+        std::string text;
+        int64_t t0_ms = 0;
+        int64_t t1_ms = 0;
+    };
+
+    // Lets a whisper_state live in a std::unique_ptr outside Whisper.cpp.
+    struct StateDeleter {
+        void operator()(whisper_state *state) const;
+    };
+
+    using StatePtr = std::unique_ptr<whisper_state, StateDeleter>;
+
+    class WhisperImpl; // Forward declaration
+
+    // Exclusive use of one pooled state. It goes back to the pool (and wakes
+    // one waiting caller) when the lease is destroyed.
+    class StateLease {
+    public:
+        StateLease(StateLease &&other) noexcept;
+
+        StateLease(const StateLease &) = delete;
+
+        StateLease &operator=(const StateLease &) = delete;
+
+        StateLease &operator=(StateLease &&) = delete;
+
+        ~StateLease();
+
+        whisper_state *get() const { return state_; }
+
+    private:
+        friend class Whisper;
+
+        StateLease(WhisperImpl *owner, whisper_state *state);
+
+        WhisperImpl *owner_ = nullptr;
+        whisper_state *state_ = nullptr;
+    };
+
+    struct PoolStats {
+        size_t size = 0;
+        size_t in_use = 0;
+        uint64_t leases = 0;
+        uint64_t waits = 0; // Leases that had to wait for a free state
+        double wait_ms = 0.0; // Total time spent waiting
+    };
+
     // Factory function to create and initialize a Whisper instance.
     // UPDATED: Returns a unique_ptr for automatic memory management.
-    static std::unique_ptr<Whisper> create(const std::string &model_path);
+    // `n_states` decoder states are allocated up front; decode threads are
+    // split between them.
+    static std::unique_ptr<Whisper> create(const std::string &model_path, int n_states = 1);
 
     // UPDATED: Public destructor is required for std::unique_ptr.
     // Its definition is in the .cpp file to allow PIMPL with an incomplete type.
@@ -22,8 +80,21 @@ public:
 
     // Transcribe a chunk of audio.
     // Audio data must be 16kHz, 32-bit float, mono.
+    // Safe to call from several threads; blocks while every pooled state is busy.
     std::string process_audio(const std::vector<float> &audio_data);
 
+    // Blocks until a pooled state is free.
+    StateLease lease_state();
+
+    PoolStats pool_stats() const;
+
+    // Allocates an additional decoder state outside the pool, for a caller that
+    // needs one permanently (e.g. streaming partials) without starving the pool.
+    StatePtr create_state();
+
+    // Transcribe with a caller-owned state and return timestamped segments.
+    std::vector<Segment> transcribe(whisper_state *state, const float *samples, size_t n_samples);
+
     // REMOVED: No longer needed, unique_ptr handles destruction.
     // void destroy();
 
@@ -32,7 +103,6 @@ private:
     Whisper();
 
     // Opaque pointer to the actual implementation details.
-    class WhisperImpl; // Forward declaration
     WhisperImpl *impl_ = nullptr;
 };
 
@@ -0,0 +1,63 @@
+#ifndef LOKI_EMBEDDINGCACHE_H
+#define LOKI_EMBEDDINGCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace loki {
+    namespace intent {
+        // Read-only, memory-mapped store of prompt embeddings so FastClassifier
+        // doesn't re-encode the whole catalog on every launch.
+        //
+        // File layout (native endianness):
+        //   header   { "LOKIEMB1", version, dim, model_hash, count }
+        //   keys     uint64_t[count], sorted (FNV-1a of the normalized prompt)
+        //   vectors  float[count][dim], in key order
+        //
+        // Opening maps the file and validates the header; lookups binary-search
+        // the key array in place, so nothing is parsed or copied up front.
+        // A file written for a different model hash is treated as empty.
+        class EmbeddingCache {
+        public:
+            struct Entry {
+                uint64_t key;
+                const float *embedding;
+            };
+
+            // Never returns null: a missing, corrupt or stale file gives an empty cache.
+            static std::unique_ptr<EmbeddingCache> open(const std::string &path, uint64_t model_hash);
+
+            // Writes a new cache file next to `path` and renames it into place.
+            // Duplicate keys are written once.
+            static bool write(const std::string &path, uint64_t model_hash, size_t dim, std::vector<Entry> entries);
+
+            ~EmbeddingCache();
+
+            EmbeddingCache(const EmbeddingCache &) = delete;
+
+            EmbeddingCache &operator=(const EmbeddingCache &) = delete;
+
+            // The cached vector (dim() floats), or nullptr.
+            const float *find(uint64_t key) const;
+
+            size_t size() const { return count_; }
+            size_t dim() const { return dim_; }
+
+        private:
+            EmbeddingCache() = default;
+
+            class MappedFile;
+            std::unique_ptr<MappedFile> file_;
+            const uint64_t *keys_ = nullptr;
+            const float *vectors_ = nullptr;
+            size_t count_ = 0;
+            size_t dim_ = 0;
+        };
+    } // namespace intent
+} // namespace loki
+
+#endif //LOKI_EMBEDDINGCACHE_H
@@ -0,0 +1,95 @@
+#ifndef LOKI_EMBEDDINGMATRIX_H
+#define LOKI_EMBEDDINGMATRIX_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace loki {
+    namespace intent {
+        // Minimal allocator so matrix rows start on a SIMD-friendly boundary.
+        template<typename T, size_t Alignment>
+        struct AlignedAllocator {
+            using value_type = T;
+
+            template<typename U>
+            struct rebind {
+                using other = AlignedAllocator<U, Alignment>;
+            };
+
+            AlignedAllocator() = default;
+
+            template<typename U>
+            AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {
+            }
+
+            T *allocate(size_t n) {
+                return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+            }
+
+            void deallocate(T *p, size_t) noexcept {
+                ::operator delete(p, std::align_val_t(Alignment));
+            }
+
+            template<typename U>
+            bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept { return true; }
+
+            template<typename U>
+            bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept { return false; }
+        };
+
+        // Intent embeddings stored as one contiguous, row-major matrix. Rows are
+        // L2-normalized when added, so cosine similarity against a normalized
+        // query is a plain dot product, and scoring every row is a single
+            // matrix-vector product run by the best kernel this build and CPU
+        // support (AVX2+FMA, NEON, or scalar).
+        class EmbeddingMatrix {
+        public:
+            struct Match {
+                size_t index = 0;
+                float score = 0.0f;
+                bool found = false;
+            };
+
+            // Scales `v` to unit length in place. Returns false for empty or all-zero vectors.
+            static bool normalize(std::vector<float> &v);
+
+            // Dot product of two `n`-float vectors with the kernel chosen at startup.
+            static float dot(const float *a, const float *b, size_t n);
+
+            // "avx2", "neon" or "scalar".
+            static const char *kernel_name();
+
+            // Normalizes and appends `embedding`. The first row fixes the dimension;
+            // rows with a different size or zero norm are rejected.
+            bool add_row(const std::vector<float> &embedding);
+
+            bool add_row(const float *embedding, size_t n);
+
+            void clear();
+
+            size_t rows() const { return rows_; }
+            size_t dim() const { return dim_; }
+
+            const float *row(size_t i) const { return data_.data() + i * stride_; }
+
+            // Writes the similarity of every row to `out` (resized to rows()).
+            // `query` must already be normalized and have dim() elements.
+            void scores(const float *query, std::vector<float> &out) const;
+
+            // The highest-scoring row for a normalized query.
+            Match best_match(const float *query) const;
+
+        private:
+            static constexpr size_t ALIGNMENT = 32; // One AVX register
+            static constexpr size_t ROW_PAD = ALIGNMENT / sizeof(float);
+
+            size_t dim_ = 0;
+            size_t stride_ = 0; // dim_ rounded up so every row stays aligned
+            size_t rows_ = 0;
+            std::vector<float, AlignedAllocator<float, ALIGNMENT> > data_;
+        };
+    } // namespace intent
+} // namespace loki
+
+#endif //LOKI_EMBEDDINGMATRIX_H
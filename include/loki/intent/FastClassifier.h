@@ -1,20 +1,36 @@
 #pragma once
 
+#include "loki/core/Config.h"
 #include "loki/core/EmbeddingModel.h"
+#include "loki/core/LruCache.h"
+#include "loki/intent/EmbeddingMatrix.h"
+#include "loki/intent/HnswIndex.h"
 #include "loki/intent/Intent.h"
+#include "loki/intent/SlotExtractor.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 
 // Keep this struct definition as it represents a single, processed training example.
+// Its embedding is row N of FastClassifier's intent matrix, where N is its index.
 struct KnownIntent {
     std::string text_prompt; // The original text for debugging/reference
-    std::vector<float> embedding;
     std::string type;
     std::string action;
 };
 
 namespace loki {
     namespace intent {
+        // Lowercases and drops punctuation; the form prompts and transcripts are compared in.
+        std::string normalize_text(const std::string &input);
+
         class FastClassifier {
         public:
             struct ClassificationResult {
@@ -25,17 +41,167 @@ namespace loki {
                 nlohmann::json parameters;
             };
 
+            struct Options {
+                // How the best prompt is found. The exact scan is the default; the
+                // HNSW index trades a little recall for sub-linear search on large catalogs.
+                bool use_hnsw = false;
+                size_t hnsw_min_prompts = 2000; // Smaller catalogs always use the exact scan
+                HnswOptions hnsw;
+
+                // Prompt embeddings are loaded from / saved to this file so only new
+                // or changed prompts are encoded at startup. Empty disables it.
+                std::string embedding_cache_path;
+
+                // Recently seen transcripts keep their embedding, so a repeated
+                // command skips the encoder. 0 disables it.
+                size_t transcript_cache_capacity = 256;
+
+                // Transcripts that match a prompt word for word resolve at confidence
+                // 1.0 without touching the encoder. The stopword pass also ignores
+                // filler like "please" or "hey loki".
+                bool lexical_match = true;
+                bool lexical_strip_stopwords = true;
+
+                // Watch the intents file and swap in a rebuilt catalog when it
+                // changes. Only new or edited prompts are re-encoded.
+                bool watch_intents_file = false;
+
+                // Online learning: learn() adds confident LLM classifications as
+                // new prompts, so a command that keeps missing the fast path
+                // stops needing the LLM. Learned prompts are appended to
+                // learned_prompts_path (JSON lines, empty = memory only) and loaded
+                // with the intents file on every start and reload.
+                bool online_learning = false;
+                std::string learned_prompts_path;
+                size_t learned_per_intent_cap = 50; // Per type/action, so one noisy intent can't crowd the catalog
+                float learn_min_confidence = 0.9f;
+
+                // Reads the INTENT_* keys; file paths go through Config::get_path.
+                static Options from_config(const loki::core::Config &config);
+            };
+
+            struct LearningStats {
+                uint64_t learned = 0;
+                uint64_t duplicates = 0; // Already a prompt
+                uint64_t capped = 0; // The intent already has learned_per_intent_cap learned prompts
+                uint64_t rejected = 0; // Low confidence, unknown, or parameters the slot extractor can't reproduce
+                size_t learned_prompts = 0; // In the current catalog, including ones loaded from the file
+            };
+
+            struct LexicalStats {
+                uint64_t lookups = 0;
+                uint64_t exact_hits = 0;
+                uint64_t stripped_hits = 0;
+            };
+
             // MODIFIED: The constructor now takes the path to the intents file and
             // a reference to the already-created EmbeddingModel. This is better design
             // (Dependency Injection).
             FastClassifier(const std::string &intents_path, EmbeddingModel &embedding_model);
 
+            FastClassifier(const std::string &intents_path, EmbeddingModel &embedding_model,
+                           const Options &classifier_options);
+
+            ~FastClassifier();
+
             ClassificationResult classify(const std::string &transcript) const;
 
+            // The two halves of classify(), for callers that want to start other
+            // work between them: the exact-prompt lookup (microseconds, no model)
+            // and the embedding similarity search.
+            ClassificationResult classify_lexical(const std::string &transcript) const;
+
+            ClassificationResult classify_embedding(const std::string &transcript) const;
+
+            // The unit-length embedding classify() uses for `transcript`, served from
+            // the transcript cache when possible. False if the model failed.
+            bool transcript_embedding(const std::string &transcript, std::vector<float> &embedding) const;
+
+            // Slot values for `action` found in `transcript`, as classify() would fill them.
+            nlohmann::json extract_parameters(const std::string &action, const std::string &transcript) const;
+
+            // Adds `transcript` as a prompt for `intent` (an LLM answer) and swaps in
+            // the extended catalog. Only learned when online learning is on, the
+            // answer is confident, the transcript is new, the intent is under its
+            // cap, and the slot extractor reads the same parameters the LLM gave;
+            // otherwise the fast path would route the command without them.
+            bool learn(const std::string &transcript, const loki::intent::Intent &intent);
+
+            LearningStats learning_stats() const;
+
+            // Re-reads the intents file now. Returns false, keeping the current
+            // catalog, if the file can't be read or parsed.
+            bool reload();
+
+            loki::core::LruCacheStats transcript_cache_stats() const { return transcript_embeddings_.stats(); }
+
+            LexicalStats lexical_stats() const;
+
+            uint64_t reload_count() const { return reloads_.load(std::memory_order_relaxed); }
+
         private:
-            std::vector<KnownIntent> known_intents_;
+            // Lexical key -> index into known_intents, or AMBIGUOUS_PROMPT if the
+            // same words belong to prompts with different intents.
+            using LexicalIndex = std::unordered_map<std::string, size_t>;
+            static constexpr size_t AMBIGUOUS_PROMPT = static_cast<size_t>(-1);
+
+            // Everything built from the intents file. A catalog is never modified
+            // once published: a reload builds a new one and swaps the pointer, and
+            // classify() keeps whichever catalog it loaded until it returns.
+            struct Catalog {
+                std::vector<KnownIntent> known_intents;
+                std::vector<uint64_t> prompt_keys; // Hash of each normalized prompt, parallel to known_intents
+                loki::intent::EmbeddingMatrix intent_matrix; // Normalized prompt embeddings, one row per known intent
+                std::unique_ptr<HnswIndex> ann_index; // Built over intent_matrix when enabled, otherwise null
+                SlotExtractor slot_extractor; // Compiled from the "slots" of each intent group
+                LexicalIndex exact_prompts; // Built even without lexical matching, for learn()'s duplicate check
+                LexicalIndex stripped_prompts;
+                std::unordered_map<std::string, size_t> learned_counts; // "type/action" -> learned prompts
+
+                const KnownIntent *find_lexical(const LexicalIndex &index, const std::string &key) const;
+
+                void add_lexical_prompt(LexicalIndex &index, const std::string &key, size_t intent_index,
+                                        const KnownIntent &intent);
+            };
+
+            // Prompts from the learned-prompts file, deduplicated against `seen`
+            // and capped per intent. A missing file gives none.
+            std::vector<KnownIntent> read_learned_prompts(const std::unordered_set<uint64_t> &seen) const;
+
+            // Builds a catalog from the intents file, reusing embeddings from
+            // `previous` (may be null) and the on-disk cache. Throws on a bad file.
+            std::shared_ptr<const Catalog> load_catalog(const Catalog *previous) const;
+
+            ClassificationResult match_lexical(const Catalog &catalog, const std::string &normalized_transcript) const;
+
+            ClassificationResult match_embedding(const Catalog &catalog, const std::string &normalized_transcript) const;
+
+            bool embed(const Catalog &catalog, const std::string &normalized_transcript,
+                       std::vector<float> &embedding) const;
+
+            void watch_intents_file();
+
+            const std::string intents_path_;
+            const Options options_;
             EmbeddingModel &embedding_model_; // Store a reference, don't own it.
+            std::shared_ptr<const Catalog> catalog_; // Read and replaced only via std::atomic_load/atomic_store
+            std::mutex reload_mtx_; // Serializes reload() and learn(), never taken by classify()
+            // Normalized transcript -> unit-length embedding.
+            mutable loki::core::LruCache<std::string, std::vector<float> > transcript_embeddings_;
+            mutable std::atomic<uint64_t> lexical_lookups_{0};
+            mutable std::atomic<uint64_t> lexical_exact_hits_{0};
+            mutable std::atomic<uint64_t> lexical_stripped_hits_{0};
+            std::atomic<uint64_t> reloads_{0};
+            std::atomic<uint64_t> learned_{0};
+            std::atomic<uint64_t> learn_duplicates_{0};
+            std::atomic<uint64_t> learn_capped_{0};
+            std::atomic<uint64_t> learn_rejected_{0};
             const float SIMILARITY_THRESHOLD = 0.85f; // Lowered slightly for more flexibility
+
+            std::thread watcher_;
+            std::mutex watcher_mtx_;
+            std::condition_variable watcher_cv_;
+            bool stop_watching_ = false; // Guarded by watcher_mtx_
         };
     } // namespace intent
 } // namespace loki
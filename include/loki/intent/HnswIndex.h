@@ -0,0 +1,87 @@
+#ifndef LOKI_HNSWINDEX_H
+#define LOKI_HNSWINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "loki/intent/EmbeddingMatrix.h"
+
+namespace loki {
+    namespace intent {
+        struct HnswOptions {
+            size_t M = 16; // Links per node on the upper layers (2*M on layer 0). More = better recall, more memory
+            size_t ef_construction = 100; // Candidate list size while building. More = better graph, slower build
+            size_t ef_search = 64; // Candidate list size per query. The main recall/latency knob
+            uint32_t seed = 42; // Level assignment is random; fixed so builds are reproducible
+        };
+
+        // Hierarchical Navigable Small World graph (Malkov & Yashunin) over the
+        // rows of an EmbeddingMatrix, for approximate nearest-neighbour search
+        // by cosine similarity. Query cost grows roughly with log(rows) instead
+        // of linearly, at the price of occasionally missing the true best match.
+        //
+        // The index references `matrix`, which must outlive it. Rows already
+        // indexed must not change; rows appended later are indexed by extend().
+        // Searches are const and thread-safe, but not alongside extend().
+        class HnswIndex {
+        public:
+            HnswIndex(const EmbeddingMatrix &matrix, const HnswOptions &options);
+
+            // A copy of `other`'s graph over `matrix`, whose first other.size()
+            // rows must equal other's matrix. Cheaper than a rebuild when `matrix`
+            // is a copy that grew by a few rows; follow with extend().
+            HnswIndex(const HnswIndex &other, const EmbeddingMatrix &matrix);
+
+            // Inserts the matrix rows added since the index was built or last
+            // extended, with the same level assignment a full build would continue with.
+            void extend();
+
+            // Up to `k` rows most similar to the normalized `query`, best first.
+            // `ef` overrides options().ef_search for this query when non-zero.
+            std::vector<EmbeddingMatrix::Match> search(const float *query, size_t k, size_t ef = 0) const;
+
+            EmbeddingMatrix::Match best_match(const float *query) const;
+
+            size_t size() const { return levels_.size(); }
+            int max_level() const { return max_level_; }
+            const HnswOptions &options() const { return options_; }
+
+        private:
+            struct Candidate {
+                float score;
+                uint32_t id;
+            };
+
+            float similarity(const float *query, uint32_t id) const;
+
+            // Best-first search of one layer starting from `entry`; returns at
+            // most `ef` candidates, unordered.
+            std::vector<Candidate> search_layer(const float *query, const std::vector<Candidate> &entry, size_t ef,
+                                                int level) const;
+
+            // Greedy single-neighbour descent used on the layers above the target.
+            Candidate greedy_descend(const float *query, Candidate current, int level) const;
+
+            // The paper's neighbour-selection heuristic: keep a candidate only if it
+            // is closer to the base node than to any neighbour already kept, which
+            // preserves links across clusters.
+            std::vector<uint32_t> select_neighbors(std::vector<Candidate> candidates, size_t max_links) const;
+
+            void insert(uint32_t id, int level);
+
+            size_t max_links(int level) const { return level == 0 ? 2 * options_.M : options_.M; }
+
+            const EmbeddingMatrix &matrix_;
+            const HnswOptions options_;
+            std::mt19937 rng_; // Draws node levels; kept so extend() continues the sequence
+            std::vector<int> levels_; // Top layer of each node
+            std::vector<std::vector<std::vector<uint32_t> > > links_; // [node][layer] -> neighbours
+            uint32_t entry_point_ = 0;
+            int max_level_ = -1;
+        };
+    } // namespace intent
+} // namespace loki
+
+#endif //LOKI_HNSWINDEX_H
@@ -1,25 +1,88 @@
 #ifndef LOKI_INTENTCLASSIFIER_H
 #define LOKI_INTENTCLASSIFIER_H
 
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <string>
 
 #include "Intent.h"
 #include "nlohmann/json.hpp"
-#include "loki/core/OllamaClient.h"
+#include "loki/core/ILLMBackend.h"
 
 namespace loki {
     namespace intent {
         class IntentClassifier {
         public:
-            // Constructor takes a reference to an existing OllamaClient
-            explicit IntentClassifier(loki::core::OllamaClient &ollama_client);
+            // Constructor takes a reference to an existing LLM backend (Ollama or in-process llama.cpp).
+            // With `constrain_output` the model can only emit an intent object from
+            // the schema in the system prompt, so every finished answer parses.
+            explicit IntentClassifier(loki::core::ILLMBackend &backend, bool constrain_output = true);
 
             // The main function of this class: takes text, returns a structured Intent
             loki::intent::Intent classify(const std::string &transcript);
 
+            // An LLM classification started before we know whether it is needed.
+            // Call get() to wait for the result, or cancel() to abandon it; a
+            // speculation that is destroyed without get() is cancelled.
+            class Speculation {
+            public:
+                ~Speculation();
+
+                loki::intent::Intent get();
+
+                void cancel();
+
+            private:
+                friend class IntentClassifier;
+
+                explicit Speculation(IntentClassifier &owner) : owner_(owner) {
+                }
+
+                IntentClassifier &owner_;
+                std::shared_ptr<std::atomic<bool> > cancelled_ = std::make_shared<std::atomic<bool> >(false);
+                std::future<loki::intent::Intent> result_;
+                bool settled_ = false; // get() or cancel() already called
+            };
+
+            struct SpeculationStats {
+                uint64_t started = 0;
+                uint64_t used = 0; // The fast path missed and the LLM answer was taken
+                uint64_t cancelled = 0; // Aborted while the request was still running
+                uint64_t discarded = 0; // Finished but not needed
+            };
+
+            // Starts classify() on a background thread. Only one speculation
+            // should be in flight at a time, since cancel() stops whatever
+            // request the shared backend is running.
+            std::unique_ptr<Speculation> classify_speculative(const std::string &transcript);
+
+            SpeculationStats speculation_stats() const;
+
+            struct ParseStats {
+                uint64_t responses = 0;
+                uint64_t failures = 0; // Fell back to "unknown" because the answer wasn't a valid intent
+            };
+
+            ParseStats parse_stats() const;
+
+            // The grammar and JSON schema used when output is constrained.
+            const loki::core::OutputFormat &output_format() const { return output_format_; }
+
         private:
-            loki::core::OllamaClient &ollama_client_; // Use a reference, don't own the client
+            loki::intent::Intent parse_response(const std::string &llm_response_str) const;
+
+            loki::core::ILLMBackend &backend_; // Use a reference, don't own the backend
             std::string system_prompt_; // We'll build a powerful prompt for classification
+            loki::core::OutputFormat output_format_; // Derived from the same type/action schema
+            bool constrain_output_;
+            mutable std::atomic<uint64_t> responses_parsed_{0};
+            mutable std::atomic<uint64_t> parse_failures_{0};
+            std::atomic<uint64_t> speculations_started_{0};
+            std::atomic<uint64_t> speculations_used_{0};
+            std::atomic<uint64_t> speculations_cancelled_{0};
+            std::atomic<uint64_t> speculations_discarded_{0};
         };
     } // namespace intent
 } // namespace loki
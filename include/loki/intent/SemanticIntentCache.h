@@ -0,0 +1,103 @@
+#ifndef LOKI_SEMANTICINTENTCACHE_H
+#define LOKI_SEMANTICINTENTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "loki/core/Config.h"
+#include "loki/intent/FastClassifier.h"
+#include "loki/intent/Intent.h"
+
+namespace loki {
+    namespace intent {
+        // Remembers what the LLM answered for earlier fast-path misses, so a
+        // near-paraphrase of one ("could you open the browser" after "can you
+        // start the browser") is answered without another LLM call.
+        //
+        // Entries are keyed by the transcript embedding FastClassifier already
+        // computed for its own search, so a lookup costs one dot product per
+        // entry and no extra encoding. A hit only counts if the new transcript
+        // yields the same parameters the slot extractor can fill; a cached
+        // free-text parameter (a search query, an expression) would otherwise
+        // be replayed for a different command, so those intents only hit on an
+        // identical transcript.
+        //
+        // Entries expire after the TTL, the least recently used one is evicted
+        // at capacity, and the cache is saved as JSON on save() and on
+        // destruction. A file written with another embedding model is ignored.
+        class SemanticIntentCache {
+        public:
+            struct Options {
+                float threshold = 0.92f; // Cosine similarity needed for a hit; above FastClassifier's 0.85
+                size_t capacity = 512; // 0 disables the cache
+                int64_t ttl_seconds = 7 * 24 * 3600; // 0 = entries never expire
+                float min_confidence = 0.7f; // LLM answers below this aren't stored
+                std::string path; // JSON file; empty keeps the cache in memory only
+
+                // Reads the LLM_CACHE_* keys; the path goes through Config::get_path.
+                static Options from_config(const loki::core::Config &config);
+            };
+
+            struct Stats {
+                uint64_t lookups = 0;
+                uint64_t hits = 0;
+                uint64_t exact_hits = 0; // Same normalized transcript as the stored one
+                uint64_t rejected = 0; // Similar enough, but the parameters didn't carry over
+                uint64_t expired = 0;
+                uint64_t evictions = 0;
+                uint64_t inserts = 0;
+                size_t size = 0;
+                size_t capacity = 0;
+            };
+
+            SemanticIntentCache(const FastClassifier &fast_classifier, uint64_t model_hash, const Options &options);
+
+            ~SemanticIntentCache();
+
+            SemanticIntentCache(const SemanticIntentCache &) = delete;
+
+            SemanticIntentCache &operator=(const SemanticIntentCache &) = delete;
+
+            // Copies the stored intent for a transcript similar to `transcript`
+            // into `intent`, with parameters re-extracted from `transcript`.
+            bool lookup(const std::string &transcript, Intent &intent);
+
+            // Stores an LLM answer for `transcript`. Unknown or low-confidence
+            // intents are ignored.
+            void insert(const std::string &transcript, const Intent &intent);
+
+            // Writes the cache file now, if anything changed since the last save.
+            bool save();
+
+            Stats stats() const;
+
+        private:
+            struct Entry {
+                std::string transcript; // Normalized
+                Intent intent;
+                int64_t created = 0; // Unix seconds, so TTLs survive restarts
+                uint64_t last_used = 0; // Logical clock for LRU eviction
+                std::vector<float> embedding; // Unit length
+            };
+
+            bool is_expired(const Entry &entry, int64_t now) const;
+
+            void load();
+
+            const FastClassifier &fast_classifier_;
+            const uint64_t model_hash_;
+            const Options options_;
+
+            mutable std::mutex mtx_;
+            std::vector<Entry> entries_;
+            uint64_t clock_ = 0;
+            bool dirty_ = false;
+            Stats stats_;
+        };
+    } // namespace intent
+} // namespace loki
+
+#endif //LOKI_SEMANTICINTENTCACHE_H
@@ -0,0 +1,86 @@
+#ifndef LOKI_SLOTEXTRACTOR_H
+#define LOKI_SLOTEXTRACTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace loki {
+    namespace intent {
+        // Pulls slot values ("chrome", "up", 50) out of a normalized transcript
+        // in a single left-to-right pass.
+        //
+        // Vocabulary phrases of every action are compiled into one Aho-Corasick
+        // automaton over a reduced byte alphabet, stored as a dense transition
+        // table, so scanning costs one table lookup per byte no matter how many
+        // phrases there are. Matches only count on whole-word boundaries, so
+        // "mute" does not fire inside "unmute". Number and percent slots are
+        // filled from digit runs and number words ("twenty five") found in the
+        // same pass.
+        class SlotExtractor {
+        public:
+            enum class NumericKind {
+                Number, // First number in the transcript
+                Percent // First number followed by "percent", else the first one in 0..100
+            };
+
+            // `phrase` must already be normalized the way transcripts are.
+            void add_phrase(const std::string &action, const std::string &slot, const std::string &phrase,
+                            const std::string &value);
+
+            void add_numeric_slot(const std::string &action, const std::string &slot, NumericKind kind);
+
+            // Builds the automaton. Call once after the last add_*() and before extract().
+            void compile();
+
+            // Slot name -> value for `action`; an empty object if nothing matched.
+            // When a slot matches more than once the leftmost, then longest, phrase wins.
+            nlohmann::json extract(const std::string &action, const std::string &normalized_text) const;
+
+            size_t pattern_count() const { return patterns_.size(); }
+            size_t state_count() const { return outputs_.size(); }
+
+        private:
+            enum class PatternKind : uint8_t { Phrase, NumberWord, Hundred, PercentWord };
+
+            struct Pattern {
+                PatternKind kind;
+                uint32_t action = 0;
+                uint32_t slot = 0;
+                uint32_t length = 0;
+                int value_number = 0; // NumberWord only
+                std::string value; // Phrase only
+                std::string text;
+            };
+
+            struct SlotDef {
+                std::string name;
+                bool numeric = false;
+                NumericKind numeric_kind = NumericKind::Number;
+            };
+
+            uint32_t action_id(const std::string &action);
+
+            uint32_t slot_id(uint32_t action, const std::string &slot);
+
+            void add_pattern(Pattern pattern);
+
+            std::unordered_map<std::string, uint32_t> action_ids_;
+            std::vector<std::vector<SlotDef> > slots_; // Per action
+            std::vector<Pattern> patterns_;
+
+            // Compiled automaton. Byte -> alphabet class (0 = not in any pattern),
+            // then delta_[state * alphabet_size_ + class] is the next state.
+            uint16_t byte_class_[256] = {};
+            size_t alphabet_size_ = 0;
+            std::vector<int32_t> delta_;
+            std::vector<std::vector<uint32_t> > outputs_; // Patterns ending in each state, incl. via suffix links
+        };
+    } // namespace intent
+} // namespace loki
+
+#endif //LOKI_SLOTEXTRACTOR_H
@@ -1,6 +1,43 @@
 #include "loki/agents/SystemControlAgent.h"
 #include <iostream>
+
+#ifdef _WIN32
 #include <windows.h> // Required for ShellExecuteA on Windows
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <thread>
+extern char **environ;
+#endif
+
+// Starts `app_name` detached from LOKI. Returns false if it could not be found or started.
+static bool launch_application(const std::string &app_name) {
+#ifdef _WIN32
+    // ShellExecuteA is a flexible way to launch applications on Windows.
+    // It searches the system PATH, so you can launch "notepad.exe" or "chrome.exe" easily.
+    HINSTANCE result = ShellExecuteA(
+        NULL, // handle to parent window
+        "open", // verb
+        app_name.c_str(), // file to open
+        NULL, // parameters for the file
+        NULL, // default directory
+        SW_SHOWNORMAL // show command
+    );
+
+    // According to Microsoft Docs, a return value > 32 indicates success.
+    return (intptr_t) result > 32;
+#else
+    // posix_spawnp searches PATH the same way a shell would.
+    pid_t pid;
+    char *argv[] = {const_cast<char *>(app_name.c_str()), nullptr};
+    if (posix_spawnp(&pid, app_name.c_str(), nullptr, nullptr, argv, environ) != 0) {
+        return false;
+    }
+    // Reap the child whenever it exits so it doesn't linger as a zombie.
+    std::thread([pid] { waitpid(pid, nullptr, 0); }).detach();
+    return true;
+#endif
+}
 
 std::string SystemControlAgent::get_name() const {
     // This name MUST match the "type" from the IntentClassifier.
@@ -14,26 +51,16 @@ std::string SystemControlAgent::execute(const loki::intent::Intent &intent) {
         }
         std::string app_name = intent.parameters["name"];
 
+#ifdef _WIN32
         // Append .exe if it's not already there for robustness.
         if (app_name.rfind(".exe") == std::string::npos) {
             app_name += ".exe";
         }
+#endif
 
         std::cout << "AGENT_LOG: Attempting to launch '" << app_name << "'..." << std::endl;
 
-        // ShellExecuteA is a flexible way to launch applications on Windows.
-        // It searches the system PATH, so you can launch "notepad.exe" or "chrome.exe" easily.
-        HINSTANCE result = ShellExecuteA(
-            NULL, // handle to parent window
-            "open", // verb
-            app_name.c_str(), // file to open
-            NULL, // parameters for the file
-            NULL, // default directory
-            SW_SHOWNORMAL // show command
-        );
-
-        // According to Microsoft Docs, a return value > 32 indicates success.
-        if ((intptr_t) result > 32) {
+        if (launch_application(app_name)) {
             // Success! Return a friendly confirmation message.
             return "Okay, launching " + intent.parameters["name"].get<std::string>();
         } else {
@@ -0,0 +1,144 @@
+#include "loki/core/AudioRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace loki {
+    namespace core {
+        static size_t next_power_of_two(size_t n) {
+            size_t p = 1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        AudioRingBuffer::AudioRingBuffer(size_t capacity_frames)
+            : buffer_(next_power_of_two(std::max<size_t>(capacity_frames, 2))),
+              mask_(buffer_.size() - 1) {
+#if defined(_WIN32)
+            wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+#endif
+        }
+
+        AudioRingBuffer::~AudioRingBuffer() {
+#if defined(_WIN32)
+            if (wake_event_) CloseHandle(wake_event_);
+#endif
+        }
+
+        bool AudioRingBuffer::can_block() const {
+#if defined(_WIN32)
+            return wake_event_ != nullptr;
+#elif defined(__linux__)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void AudioRingBuffer::signal() {
+#if defined(_WIN32)
+            if (wake_event_) SetEvent(wake_event_);
+#elif defined(__linux__)
+            wake_word_.store(1, std::memory_order_release);
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&wake_word_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+        }
+
+        void AudioRingBuffer::sleep(std::chrono::milliseconds timeout) {
+#if defined(_WIN32)
+            if (wake_event_) {
+                WaitForSingleObject(wake_event_, static_cast<DWORD>(timeout.count()));
+                return;
+            }
+#elif defined(__linux__)
+            if (wake_word_.exchange(0, std::memory_order_acquire) == 0) {
+                timespec ts{};
+                ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+                ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000L;
+                // Returns at once if signal() set the word in the meantime.
+                syscall(SYS_futex, reinterpret_cast<uint32_t *>(&wake_word_), FUTEX_WAIT_PRIVATE, 0, &ts, nullptr, 0);
+                wake_word_.store(0, std::memory_order_relaxed);
+            }
+            return;
+#endif
+            std::this_thread::sleep_for(std::min(timeout, std::chrono::milliseconds(1)));
+        }
+
+        size_t AudioRingBuffer::write(const float *frames, size_t count) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            const size_t free_space = buffer_.size() - (head - tail);
+            const size_t to_write = std::min(count, free_space);
+
+            // Copy in at most two contiguous pieces (before and after the wrap point).
+            const size_t start = head & mask_;
+            const size_t first = std::min(to_write, buffer_.size() - start);
+            std::memcpy(buffer_.data() + start, frames, first * sizeof(float));
+            std::memcpy(buffer_.data(), frames + first, (to_write - first) * sizeof(float));
+
+            head_.store(head + to_write, std::memory_order_release);
+
+            // Pairs with the fence in wait_for(): either the consumer sees the new
+            // head, or this sees consumer_waiting_ and wakes it.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (to_write > 0 && consumer_waiting_.load(std::memory_order_relaxed) &&
+                consumer_waiting_.exchange(false, std::memory_order_relaxed)) {
+                signal();
+            }
+
+            written_.fetch_add(to_write, std::memory_order_relaxed);
+            if (to_write < count) {
+                dropped_.fetch_add(count - to_write, std::memory_order_relaxed);
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return to_write;
+        }
+
+        size_t AudioRingBuffer::read(float *out, size_t count) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t head = head_.load(std::memory_order_acquire);
+            const size_t to_read = std::min(count, head - tail);
+
+            const size_t start = tail & mask_;
+            const size_t first = std::min(to_read, buffer_.size() - start);
+            std::memcpy(out, buffer_.data() + start, first * sizeof(float));
+            std::memcpy(out + first, buffer_.data(), (to_read - first) * sizeof(float));
+
+            tail_.store(tail + to_read, std::memory_order_release);
+            return to_read;
+        }
+
+        size_t AudioRingBuffer::available() const {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        bool AudioRingBuffer::wait_for(size_t count, std::chrono::milliseconds timeout) {
+            consumer_waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (available() >= count) {
+                consumer_waiting_.store(false, std::memory_order_relaxed);
+                return true;
+            }
+            sleep(timeout);
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+            return available() >= count;
+        }
+
+        void AudioRingBuffer::interrupt() {
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+            signal();
+        }
+    } // namespace core
+} // namespace loki
@@ -1,4 +1,5 @@
 #include "loki/core/Config.h"
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <algorithm> // For std::remove
@@ -54,5 +55,18 @@ namespace loki {
             }
             return default_value;
         }
+
+        std::string Config::get_path(const std::string &key, const std::string &default_value) const {
+            const std::string value = get(key, default_value);
+            if (value.empty()) return value;
+            const std::filesystem::path p(value);
+            if (p.is_absolute()) {
+                if (!std::filesystem::exists(p)) {
+                    std::cerr << "WARNING: Absolute path from config for '" << key << "' not found: " << p << std::endl;
+                }
+                return p.string();
+            }
+            return base_dir.empty() ? value : (std::filesystem::path(base_dir) / p).string();
+        }
     } // namespace core
 } // namespace loki
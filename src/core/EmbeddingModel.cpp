@@ -1,5 +1,9 @@
 #include "loki/core/EmbeddingModel.h"
+#include "loki/core/Hash.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <vector>
 #include <stdexcept>
 
@@ -7,9 +11,19 @@
 #include "llama_cpp/include/llama.h"
 
 
+// The long-lived context only ever holds one query.
+static constexpr uint32_t EMBEDDING_QUERY_TOKENS = 512;
+// Batched encodes get their own short-lived context: up to this many tokens
+// and sequences per llama_encode.
+static constexpr uint32_t EMBEDDING_BATCH_TOKENS = 2048;
+static constexpr uint32_t EMBEDDING_BATCH_SEQUENCES = 32;
+
 struct EmbeddingModel::EmbeddingModelImpl {
     llama_model *model = nullptr;
-    llama_context *ctx = nullptr;
+    llama_context *ctx = nullptr; // Query context for get_embeddings
+    std::mutex mtx; // llama_context is not thread-safe; classify runs on several threads
+    std::string model_path;
+    uint64_t model_hash = 0; // Guarded by mtx; 0 until first requested
 
 
     ~EmbeddingModelImpl() {
@@ -25,6 +39,30 @@ struct EmbeddingModel::EmbeddingModelImpl {
 
         llama_backend_free();
     }
+
+    // Embedding models use non-causal attention, so a whole batch has to fit
+    // in one physical ubatch: n_ctx, n_batch and n_ubatch are all `n_tokens`.
+    llama_context *create_context(uint32_t n_tokens, uint32_t n_seq_max) const {
+        auto cparams = llama_context_default_params();
+        cparams.n_ctx = n_tokens;
+        cparams.n_batch = n_tokens;
+        cparams.n_ubatch = n_tokens;
+        cparams.n_seq_max = n_seq_max;
+        cparams.embeddings = true;
+        return llama_init_from_model(model, cparams);
+    }
+
+    bool tokenize(const std::string &text, std::vector<llama_token> &tokens) const {
+        tokens.resize(text.size() + 2);
+        const llama_vocab *vocab = llama_model_get_vocab(model);
+        int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), tokens.size(), true, false);
+        if (n_tokens < 0) {
+            std::cerr << "Error: LLaMA tokenization failed." << std::endl;
+            return false;
+        }
+        tokens.resize(n_tokens);
+        return true;
+    }
 };
 
 
@@ -47,14 +85,8 @@ bool EmbeddingModel::load(const std::string &model_path) const {
         return false;
     }
 
-    auto cparams = llama_context_default_params();
-    cparams.n_ctx = 512;
-    cparams.n_batch = 512;
-
-    cparams.embeddings = true;
-
-
-    pimpl->ctx = llama_init_from_model(pimpl->model, cparams);
+    // Sized for single queries on the hot path; get_embeddings_batch brings its own.
+    pimpl->ctx = pimpl->create_context(EMBEDDING_QUERY_TOKENS, 1);
 
     if (!pimpl->ctx) {
         std::cerr << "Error: could not create llama context for embedding model" << std::endl;
@@ -63,6 +95,7 @@ bool EmbeddingModel::load(const std::string &model_path) const {
         return false;
     }
 
+    pimpl->model_path = model_path;
     std::cout << "LOKI: Embedding model loaded successfully." << std::endl;
     return true;
 }
@@ -73,16 +106,12 @@ std::vector<float> EmbeddingModel::get_embeddings(const std::string &text) {
     }
 
 
-    auto tokens_list = std::vector<llama_token>(text.size() + 2);
-    const llama_vocab *vocab = llama_model_get_vocab(pimpl->model);
-
-    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), tokens_list.data(), tokens_list.size(),
-                                  true, false);
-    if (n_tokens < 0) {
-        std::cerr << "Error: LLaMA tokenization failed." << std::endl;
+    std::lock_guard<std::mutex> lock(pimpl->mtx);
+    std::vector<llama_token> tokens_list;
+    if (!pimpl->tokenize(text, tokens_list)) {
         return {};
     }
-    tokens_list.resize(n_tokens);
+    const int n_tokens = static_cast<int>(tokens_list.size());
 
 
     llama_memory_clear(llama_get_memory(pimpl->ctx), true);
@@ -106,6 +135,95 @@ std::vector<float> EmbeddingModel::get_embeddings(const std::string &text) {
 }
 
 
+std::vector<std::vector<float> > EmbeddingModel::get_embeddings_batch(const std::vector<std::string> &texts) {
+    std::vector<std::vector<float> > results(texts.size());
+    if (!pimpl->ctx || !pimpl->model || texts.empty()) {
+        return results;
+    }
+
+    // Bulk work runs on a context of its own, freed before returning, so the
+    // query context keeps its small compute buffer and classify() is not
+    // blocked on pimpl->mtx while a batch encodes.
+    llama_context *ctx = pimpl->create_context(EMBEDDING_BATCH_TOKENS, EMBEDDING_BATCH_SEQUENCES);
+    if (!ctx) {
+        std::cerr << "Error: could not create llama context for batched embedding" << std::endl;
+        return results;
+    }
+    const int n_embed = llama_model_n_embd(pimpl->model);
+    const uint32_t max_tokens = llama_n_batch(ctx);
+    const uint32_t max_sequences = llama_n_seq_max(ctx);
+    const uint32_t max_tokens_per_text = std::min(max_tokens, (uint32_t) llama_model_n_ctx_train(pimpl->model));
+
+    std::vector<std::vector<llama_token> > tokens(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (pimpl->tokenize(texts[i], tokens[i]) && tokens[i].size() > max_tokens_per_text) {
+            tokens[i].resize(max_tokens_per_text);
+        }
+    }
+
+    llama_batch batch = llama_batch_init(static_cast<int32_t>(max_tokens), 0, 1);
+    size_t next = 0;
+    while (next < texts.size()) {
+        // Pack texts until either the token or the sequence budget is used up.
+        std::vector<size_t> members;
+        batch.n_tokens = 0;
+        while (next < texts.size() && members.size() < max_sequences) {
+            if (tokens[next].empty()) {
+                next++; // Tokenization failed; its result stays empty
+                continue;
+            }
+            if (batch.n_tokens + tokens[next].size() > max_tokens) break;
+            const auto seq_id = static_cast<llama_seq_id>(members.size());
+            for (size_t pos = 0; pos < tokens[next].size(); ++pos) {
+                const int32_t t = batch.n_tokens++;
+                batch.token[t] = tokens[next][pos];
+                batch.pos[t] = static_cast<llama_pos>(pos);
+                batch.n_seq_id[t] = 1;
+                batch.seq_id[t][0] = seq_id;
+                batch.logits[t] = true;
+            }
+            members.push_back(next++);
+        }
+        if (members.empty()) continue;
+
+        llama_memory_clear(llama_get_memory(ctx), true);
+        if (llama_encode(ctx, batch)) {
+            std::cerr << "Error: LLaMA llama_encode failed for a batch of " << members.size() << " texts."
+                    << std::endl;
+            continue;
+        }
+        for (size_t s = 0; s < members.size(); ++s) {
+            const float *embeddings_ptr = llama_get_embeddings_seq(ctx, static_cast<llama_seq_id>(s));
+            if (embeddings_ptr) {
+                results[members[s]].assign(embeddings_ptr, embeddings_ptr + n_embed);
+            }
+        }
+    }
+    llama_batch_free(batch);
+    llama_free(ctx);
+    return results;
+}
+
+uint64_t EmbeddingModel::model_hash() const {
+    std::lock_guard<std::mutex> lock(pimpl->mtx);
+    if (pimpl->model_hash != 0 || pimpl->model_path.empty()) {
+        return pimpl->model_hash;
+    }
+
+    std::ifstream file(pimpl->model_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: could not read embedding model to hash it: " << pimpl->model_path << std::endl;
+        return 0;
+    }
+    std::vector<char> buffer(1 << 20);
+    uint64_t hash = loki::core::FNV1A_64_OFFSET;
+    while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount() > 0) {
+        hash = loki::core::fnv1a_64(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    pimpl->model_hash = hash;
+    return hash;
+}
+
 std::unique_ptr<EmbeddingModel> EmbeddingModel::create(const std::string &model_path) {
     auto model = std::make_unique<EmbeddingModel>();
     if (model->load(model_path)) {
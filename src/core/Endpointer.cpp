@@ -0,0 +1,136 @@
+#include "loki/core/Endpointer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include "whisper_cpp/include/whisper_c_api.h"
+
+namespace loki {
+    namespace core {
+        Endpointer::Endpointer(const EndpointerOptions &options) : options_(options) {
+        }
+
+        std::unique_ptr<Endpointer> Endpointer::create(const Config &config, int sample_rate) {
+            EndpointerOptions options;
+            options.sample_rate = sample_rate;
+            options.no_speech_timeout_ms = std::stoi(config.get("VAD_NO_SPEECH_TIMEOUT_MS", "3200"));
+            options.speech_pad_ms = std::stoi(config.get("VAD_SPEECH_PAD_MS", "200"));
+            if (config.get("VAD_BACKEND", "rms") == "silero") {
+                options.threshold = config.get_float("VAD_SPEECH_THRESHOLD", 0.5f);
+                options.hangover_ms = std::stoi(config.get("VAD_HANGOVER_MS", "400"));
+                auto silero = SileroEndpointer::create(config.get_path("VAD_MODEL_PATH", "ggml-silero-v5.1.2.bin"),
+                                                       options);
+                if (silero) return silero;
+                std::cerr << "WARNING: Silero VAD unavailable, falling back to RMS endpointing." << std::endl;
+            }
+            options.threshold = config.get_float("VAD_THRESHOLD", 0.01f);
+            options.hangover_ms = std::stoi(config.get("VAD_HANGOVER_MS", "1280"));
+            return std::make_unique<RmsEndpointer>(options);
+        }
+
+        void Endpointer::reset(size_t initial_samples) {
+            initial_samples_ = initial_samples;
+            position_ = initial_samples;
+            speech_start_ = initial_samples;
+            speech_end_ = initial_samples;
+            has_speech_ = false;
+            on_reset();
+        }
+
+        bool Endpointer::process(const float *samples, size_t n_samples) {
+            const bool speech = is_speech(samples, n_samples);
+            if (speech) {
+                if (!has_speech_) {
+                    speech_start_ = position_;
+                    has_speech_ = true;
+                }
+                speech_end_ = position_ + n_samples;
+            }
+            position_ += n_samples;
+
+            const size_t samples_per_ms = static_cast<size_t>(options_.sample_rate) / 1000;
+            if (has_speech_) {
+                return position_ - speech_end_ > options_.hangover_ms * samples_per_ms;
+            }
+            return position_ - initial_samples_ > options_.no_speech_timeout_ms * samples_per_ms;
+        }
+
+        void Endpointer::trim(std::vector<float> &audio) const {
+            size_t start = 0, end = 0;
+            if (!trim_bounds(audio.size(), start, end)) return;
+            audio.erase(audio.begin() + end, audio.end());
+            audio.erase(audio.begin(), audio.begin() + start);
+        }
+
+        bool Endpointer::trim_bounds(size_t n_samples, size_t &start, size_t &end) const {
+            if (!has_speech_) return false;
+            const size_t pad = static_cast<size_t>(options_.sample_rate) * options_.speech_pad_ms / 1000;
+            const size_t lead = pad + decision_delay();
+
+            // Keep the pre-roll when speech starts right after it: the command was
+            // probably said together with the wake word.
+            start = speech_start_ <= initial_samples_ + lead ? 0 : speech_start_ - lead;
+            end = std::min(n_samples, speech_end_ + pad);
+            return start < end && (start > 0 || end < n_samples);
+        }
+
+        bool RmsEndpointer::is_speech(const float *samples, size_t n_samples) {
+            if (n_samples == 0) return false;
+            double sum_squares = 0.0;
+            for (size_t i = 0; i < n_samples; ++i) {
+                sum_squares += samples[i] * samples[i];
+            }
+            return std::sqrt(sum_squares / n_samples) >= options_.threshold;
+        }
+
+        std::unique_ptr<SileroEndpointer> SileroEndpointer::create(const std::string &model_path,
+                                                                   const EndpointerOptions &options,
+                                                                   int context_ms) {
+            whisper_vad_context_params params = whisper_vad_default_context_params();
+            params.n_threads = std::min(4, (int) std::thread::hardware_concurrency());
+            whisper_vad_context *vctx = whisper_vad_init_from_file_with_params(model_path.c_str(), params);
+            if (!vctx) {
+                std::cerr << "Error: failed to load Silero VAD model from: " << model_path << std::endl;
+                return nullptr;
+            }
+            const size_t context_samples = static_cast<size_t>(options.sample_rate) * context_ms / 1000;
+            return std::unique_ptr<SileroEndpointer>(new SileroEndpointer(vctx, options, context_samples));
+        }
+
+        SileroEndpointer::SileroEndpointer(whisper_vad_context *vctx, const EndpointerOptions &options,
+                                           size_t context_samples)
+            : Endpointer(options), vctx_(vctx), context_samples_(context_samples) {
+            context_.reserve(context_samples_);
+        }
+
+        SileroEndpointer::~SileroEndpointer() {
+            if (vctx_) {
+                whisper_vad_free(vctx_);
+                vctx_ = nullptr;
+            }
+        }
+
+        void SileroEndpointer::on_reset() {
+            context_.clear();
+            speech_ = false;
+        }
+
+        bool SileroEndpointer::is_speech(const float *samples, size_t n_samples) {
+            // Collect a full context of new audio, then run the VAD over it once.
+            // Until then the previous run's decision stands.
+            context_.insert(context_.end(), samples, samples + n_samples);
+            if (context_.size() < context_samples_) {
+                return speech_;
+            }
+
+            speech_ = false;
+            if (whisper_vad_detect_speech(vctx_, context_.data(), static_cast<int>(context_.size()))) {
+                const int n_probs = whisper_vad_n_probs(vctx_);
+                speech_ = n_probs > 0 && whisper_vad_probs(vctx_)[n_probs - 1] >= options_.threshold;
+            }
+            context_.clear();
+            return speech_;
+        }
+    } // namespace core
+} // namespace loki
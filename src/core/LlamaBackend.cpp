@@ -0,0 +1,347 @@
+#include "loki/core/LlamaBackend.h"
+#include "loki/core/JsonObjectScanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "llama_cpp/include/llama.h"
+
+namespace loki {
+    namespace core {
+        LlamaBackendOptions LlamaBackendOptions::from_config(const Config &config) {
+            LlamaBackendOptions options;
+            options.n_threads = std::stoi(config.get("LLM_THREADS", "0"));
+            options.n_gpu_layers = std::stoi(config.get("LLM_GPU_LAYERS", "0"));
+            options.reuse_prefix = config.get("LLM_PROMPT_CACHE", "1") == "1";
+            return options;
+        }
+
+        struct LlamaBackend::LlamaBackendImpl {
+            llama_model *model = nullptr;
+            llama_context *ctx = nullptr;
+            llama_sampler *sampler = nullptr;
+            const llama_vocab *vocab = nullptr;
+            llama_sampler *grammar = nullptr; // Built from grammar_text, reset per request
+            std::string grammar_text;
+            std::vector<llama_token_data> candidates; // Scratch for the constrained slow path
+            std::vector<llama_token> cached; // Prompt tokens whose KV entries are in sequence 0
+            bool prefix_dropped = false; // A decode error cleared the cache, prefilled prefix included
+            std::string chat_template; // Empty: llama.cpp's chatml fallback
+            LlamaBackendOptions options;
+            std::mutex mtx; // One request at a time on the shared context
+            std::atomic<bool> abort{false}; // Set by cancel(); read by the decode abort callback
+
+            ~LlamaBackendImpl() {
+                if (grammar) llama_sampler_free(grammar);
+                if (sampler) llama_sampler_free(sampler);
+                if (ctx) llama_free(ctx);
+                if (model) llama_model_free(model);
+            }
+
+            // ggml calls this between graph nodes; returning true aborts llama_decode.
+            static bool abort_callback(void *data) {
+                return static_cast<LlamaBackendImpl *>(data)->abort.load(std::memory_order_relaxed);
+            }
+
+            std::string format_prompt(const std::string &system_prompt, const std::string &user_prompt) const {
+                const llama_chat_message messages[] = {
+                    {"system", system_prompt.c_str()},
+                    {"user", user_prompt.c_str()}
+                };
+                const char *tmpl = chat_template.empty() ? "chatml" : chat_template.c_str();
+                std::vector<char> buffer(2 * (system_prompt.size() + user_prompt.size()) + 256);
+                int32_t length = llama_chat_apply_template(tmpl, messages, 2, true, buffer.data(),
+                                                           static_cast<int32_t>(buffer.size()));
+                if (length > static_cast<int32_t>(buffer.size())) {
+                    buffer.resize(length);
+                    length = llama_chat_apply_template(tmpl, messages, 2, true, buffer.data(), length);
+                }
+                if (length < 0) {
+                    std::cerr << "WARNING: Chat template not supported by llama.cpp; using plain text." << std::endl;
+                    return system_prompt + "\n\nUser: " + user_prompt + "\nAssistant: ";
+                }
+                return std::string(buffer.data(), length);
+            }
+
+            bool tokenize(const std::string &text, std::vector<llama_token> &tokens) const {
+                tokens.resize(text.size() + 16);
+                int32_t n = llama_tokenize(vocab, text.c_str(), static_cast<int32_t>(text.size()), tokens.data(),
+                                           static_cast<int32_t>(tokens.size()), true, true);
+                if (n < 0) {
+                    tokens.resize(-n);
+                    n = llama_tokenize(vocab, text.c_str(), static_cast<int32_t>(text.size()), tokens.data(),
+                                       static_cast<int32_t>(tokens.size()), true, true);
+                }
+                if (n < 0) return false;
+                tokens.resize(n);
+                return true;
+            }
+
+            std::string token_to_piece(llama_token token) const {
+                char buffer[256];
+                const int32_t n = llama_token_to_piece(vocab, token, buffer, sizeof(buffer), 0, false);
+                return n > 0 ? std::string(buffer, n) : std::string();
+            }
+
+            // The grammar sampler for `gbnf`, parsed once and reused while the
+            // grammar stays the same. Null if the grammar doesn't parse.
+            llama_sampler *grammar_for(const std::string &gbnf) {
+                if (gbnf != grammar_text) {
+                    if (grammar) llama_sampler_free(grammar);
+                    grammar_text = gbnf;
+                    grammar = llama_sampler_init_grammar(vocab, gbnf.c_str(), "root");
+                    if (!grammar) std::cerr << "WARNING: Invalid GBNF grammar; decoding unconstrained." << std::endl;
+                }
+                if (grammar) llama_sampler_reset(grammar);
+                return grammar;
+            }
+
+            // Returns the greedy token the grammar allows, or -1 if it allows none.
+            // The unconstrained pick `token` is checked first: it is legal most of
+            // the time, and then the whole vocabulary doesn't need masking.
+            llama_token constrain(llama_token token) {
+                llama_token_data single = {token, 0.0f, 0.0f};
+                llama_token_data_array one = {&single, 1, -1, false};
+                llama_sampler_apply(grammar, &one);
+                if (std::isfinite(single.logit)) {
+                    llama_sampler_accept(grammar, token);
+                    return token;
+                }
+
+                const float *logits = llama_get_logits_ith(ctx, -1);
+                const int32_t n_vocab = llama_vocab_n_tokens(vocab);
+                candidates.resize(n_vocab);
+                for (int32_t id = 0; id < n_vocab; ++id) candidates[id] = {id, logits[id], 0.0f};
+                llama_token_data_array all = {candidates.data(), candidates.size(), -1, false};
+                llama_sampler_apply(grammar, &all);
+                llama_token best = -1;
+                float best_logit = -INFINITY;
+                for (size_t i = 0; i < all.size; ++i) {
+                    if (all.data[i].logit > best_logit) {
+                        best_logit = all.data[i].logit;
+                        best = all.data[i].id;
+                    }
+                }
+                if (best >= 0) llama_sampler_accept(grammar, best);
+                return best;
+            }
+
+            // Feeds tokens[from..] to the context in n_batch-sized pieces. On failure
+            // `n_done` is the end of the last piece that made it into the cache.
+            bool decode(std::vector<llama_token> &tokens, size_t from, size_t &n_done) {
+                const size_t n_batch = llama_n_batch(ctx);
+                n_done = from;
+                for (size_t i = from; i < tokens.size(); i += n_batch) {
+                    const auto n = static_cast<int32_t>(std::min(n_batch, tokens.size() - i));
+                    if (llama_decode(ctx, llama_batch_get_one(tokens.data() + i, n)) != 0) return false;
+                    n_done = i + n;
+                }
+                return true;
+            }
+
+            void reset_cache() {
+                llama_memory_clear(llama_get_memory(ctx), true);
+                cached.clear();
+            }
+
+            // Brings the KV cache to `tokens` and returns how many of them were
+            // already there. Only the part after the longest common prefix with
+            // the previous prompt is evaluated; for intent classification that
+            // is the transcript, since the system prompt never changes. At least
+            // one token is always evaluated so there are logits to sample from.
+            bool evaluate_prompt(std::vector<llama_token> &tokens, size_t &n_reused) {
+                n_reused = 0;
+                if (options.reuse_prefix) {
+                    const size_t limit = std::min(cached.size(), tokens.size() - 1);
+                    while (n_reused < limit && cached[n_reused] == tokens[n_reused]) n_reused++;
+                }
+                if (!llama_memory_seq_rm(llama_get_memory(ctx), 0, static_cast<llama_pos>(n_reused), -1)) {
+                    n_reused = 0; // Partial removal unsupported by this memory type
+                    llama_memory_clear(llama_get_memory(ctx), true);
+                }
+                cached.resize(n_reused);
+                size_t n_done = 0;
+                if (!decode(tokens, n_reused, n_done)) {
+                    if (abort.load()) {
+                        // cancel() stopped it. An aborted llama_decode leaves the cache
+                        // as it was, so everything up to n_done (the system prompt,
+                        // at least) stays usable for the next request.
+                        llama_memory_seq_rm(llama_get_memory(ctx), 0, static_cast<llama_pos>(n_done), -1);
+                        cached.assign(tokens.begin(), tokens.begin() + n_done);
+                    } else {
+                        reset_cache();
+                        prefix_dropped = true;
+                    }
+                    return false;
+                }
+                cached = tokens;
+                prefix_dropped = false;
+                return true;
+            }
+        };
+
+        LlamaBackend::LlamaBackend() : pimpl_(new LlamaBackendImpl()) {
+        }
+
+        LlamaBackend::~LlamaBackend() = default;
+
+        std::unique_ptr<LlamaBackend> LlamaBackend::create(const std::string &model_path,
+                                                           const LlamaBackendOptions &options) {
+            std::cout << "LOKI: Loading in-process LLM from '" << model_path << "'..." << std::endl;
+            llama_backend_init();
+
+            std::unique_ptr<LlamaBackend> backend(new LlamaBackend());
+            LlamaBackendImpl &impl = *backend->pimpl_;
+            impl.options = options;
+
+            auto mparams = llama_model_default_params();
+            mparams.n_gpu_layers = options.n_gpu_layers;
+            impl.model = llama_model_load_from_file(model_path.c_str(), mparams);
+            if (!impl.model) {
+                std::cerr << "Error: could not load LLM from " << model_path << std::endl;
+                return nullptr;
+            }
+            impl.vocab = llama_model_get_vocab(impl.model);
+            if (const char *tmpl = llama_model_chat_template(impl.model, nullptr)) {
+                impl.chat_template = tmpl;
+            }
+
+            const int hw = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            const int n_threads = options.n_threads > 0 ? options.n_threads : std::clamp(hw / 2, 1, 8);
+            auto cparams = llama_context_default_params();
+            cparams.n_ctx = options.n_ctx;
+            cparams.n_batch = options.n_batch;
+            cparams.n_threads = n_threads;
+            cparams.n_threads_batch = n_threads;
+            cparams.abort_callback = &LlamaBackendImpl::abort_callback;
+            cparams.abort_callback_data = &impl;
+            impl.ctx = llama_init_from_model(impl.model, cparams);
+            if (!impl.ctx) {
+                std::cerr << "Error: could not create llama context for the LLM" << std::endl;
+                return nullptr;
+            }
+
+            impl.sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
+            llama_sampler_chain_add(impl.sampler, llama_sampler_init_greedy());
+
+            // Warm-up: the first decode pages in the weights and sets up the
+            // compute buffers, so the first real command doesn't pay for it.
+            std::vector<llama_token> warmup;
+            size_t n_warm = 0;
+            if (impl.tokenize(impl.format_prompt("", "hi"), warmup) && !warmup.empty()) {
+                impl.decode(warmup, 0, n_warm);
+            }
+            impl.reset_cache();
+
+            std::cout << "LOKI: In-process LLM ready (" << n_threads << " threads, n_ctx " << options.n_ctx
+                    << ", template " << (impl.chat_template.empty() ? "chatml" : "from model") << ")." << std::endl;
+            return backend;
+        }
+
+        void LlamaBackend::prefill(const std::string &system_prompt) {
+            std::lock_guard<std::mutex> lock(pimpl_->mtx);
+            LlamaBackendImpl &impl = *pimpl_;
+            if (!impl.options.reuse_prefix) return;
+            impl.abort.store(false);
+            // An empty user turn shares everything up to the user's text with real prompts.
+            std::vector<llama_token> tokens;
+            size_t n_reused = 0;
+            if (impl.tokenize(impl.format_prompt(system_prompt, ""), tokens) && tokens.size() > 1 &&
+                tokens.size() < llama_n_ctx(impl.ctx)) {
+                impl.evaluate_prompt(tokens, n_reused);
+            }
+        }
+
+        void LlamaBackend::cancel() {
+            pimpl_->abort.store(true);
+        }
+
+        std::string LlamaBackend::generate_impl(const std::string &system_prompt, const std::string &user_prompt,
+                                                const std::atomic<bool> *cancelled, bool stop_after_json,
+                                                const OutputFormat *format) {
+            std::lock_guard<std::mutex> lock(pimpl_->mtx);
+            LlamaBackendImpl &impl = *pimpl_;
+            auto is_cancelled = [cancelled] { return cancelled && cancelled->load(); };
+            if (is_cancelled()) return "";
+            impl.abort.store(false);
+
+            const auto start = std::chrono::steady_clock::now();
+            auto elapsed_ms = [&start] {
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            std::vector<llama_token> tokens;
+            if (!impl.tokenize(impl.format_prompt(system_prompt, user_prompt), tokens) || tokens.empty()) {
+                std::cerr << "Error: could not tokenize the LLM prompt." << std::endl;
+                return "[Error: Could not tokenize prompt]";
+            }
+            const auto n_ctx = static_cast<size_t>(llama_n_ctx(impl.ctx));
+            if (tokens.size() + 1 >= n_ctx) {
+                std::cerr << "Error: LLM prompt of " << tokens.size() << " tokens does not fit n_ctx " << n_ctx
+                        << std::endl;
+                return "[Error: Prompt too long]";
+            }
+
+            llama_sampler_reset(impl.sampler);
+            llama_sampler *grammar = format && !format->gbnf.empty() ? impl.grammar_for(format->gbnf) : nullptr;
+            size_t n_reused = 0;
+            const bool prefix_lost = impl.options.reuse_prefix && impl.prefix_dropped;
+            if (!impl.evaluate_prompt(tokens, n_reused)) {
+                if (is_cancelled() || impl.abort.load()) return "";
+                std::cerr << "Error: llama_decode failed on the LLM prompt." << std::endl;
+                return "[Error: LLM decode failed]";
+            }
+
+            GenerateMetrics metrics;
+            metrics.constrained = grammar != nullptr;
+            metrics.prompt_tokens = static_cast<int>(tokens.size());
+            metrics.prompt_tokens_evaluated = static_cast<int>(tokens.size() - n_reused);
+            metrics.prompt_prefix_lost = prefix_lost;
+            metrics.prompt_eval_ms = elapsed_ms();
+            JsonObjectScanner scanner;
+            std::string response;
+            size_t n_past = tokens.size();
+            bool json_done = false;
+            for (int i = 0; i < impl.options.max_tokens && n_past < n_ctx; ++i) {
+                if (is_cancelled() || impl.abort.load()) return "";
+                llama_token token = llama_sampler_sample(impl.sampler, impl.ctx, -1);
+                if (grammar) token = impl.constrain(token);
+                if (token < 0 || llama_vocab_is_eog(impl.vocab, token)) break;
+
+                const std::string piece = impl.token_to_piece(token);
+                metrics.chunks++;
+                if (!piece.empty() && metrics.first_token_ms < 0.0) metrics.first_token_ms = elapsed_ms();
+                const size_t end = json_done ? std::string::npos : scanner.feed(piece);
+                if (end != std::string::npos) {
+                    response.append(piece, 0, stop_after_json ? end : piece.size());
+                    metrics.json_complete_ms = elapsed_ms();
+                    json_done = true;
+                    if (stop_after_json) {
+                        metrics.stopped_early = true;
+                        break;
+                    }
+                } else {
+                    response += piece;
+                }
+
+                if (llama_decode(impl.ctx, llama_batch_get_one(&token, 1)) != 0) {
+                    // After an abort the prompt is still cached; the next
+                    // evaluate_prompt drops whatever was generated after it.
+                    if (is_cancelled() || impl.abort.load()) return "";
+                    impl.reset_cache();
+                    impl.prefix_dropped = true;
+                    std::cerr << "Error: llama_decode failed while generating." << std::endl;
+                    break;
+                }
+                n_past++;
+            }
+            metrics.total_ms = elapsed_ms();
+            record_metrics(metrics);
+            return response;
+        }
+    } // namespace core
+} // namespace loki
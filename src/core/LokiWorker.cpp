@@ -6,18 +6,26 @@
 #include <filesystem>
 #include <iostream>
 #include <mutex>
-#include <cmath> // Required for std::sqrt
+#include <algorithm>
 #define NOMINMAX
 #include <windows.h> // For SetEnvironmentVariableA
 #include <QCoreApplication> // ADDED: For getting application path
 
 #include "nlohmann/json.hpp"
+#include "loki/core/AudioRingBuffer.h"
+#include "loki/core/PipelineStage.h"
 #include "loki/core/Config.h"
+#include "loki/core/Endpointer.h"
+#include "loki/core/LlamaBackend.h"
 #include "loki/core/OllamaClient.h"
+#include "loki/core/PreRollBuffer.h"
+#include "loki/core/StreamingTranscriber.h"
+#include "loki/core/WakeWordDetector.h"
 #include "loki/core/Whisper.h"
 #include "loki/core/EmbeddingModel.h"
 #include "loki/intent/FastClassifier.h"
 #include "loki/intent/IntentClassifier.h"
+#include "loki/intent/SemanticIntentCache.h"
 #include "loki/AgentManager.h"
 #include "loki/agents/SystemControlAgent.h"
 #include "loki/agents/CalculationAgent.h"
@@ -27,28 +35,33 @@
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio/miniaudio.h"
 
-extern "C" {
-#include "picovoice/include/pv_porcupine.h"
-}
-
 // --- Application State Structures and Callbacks ---
 enum class AppState {
     LISTENING_FOR_WAKE_WORD,
-    RECORDING_COMMAND,
-    PROCESSING_COMMAND
+    RECORDING_COMMAND
 };
 
+// A finished command as handed from the audio thread to the transcription stage.
+struct CapturedUtterance {
+    std::vector<float> audio;
+    // Set when streaming transcription is enabled; already holds partial results.
+    std::shared_ptr<loki::core::StreamingTranscriber::Session> stream;
+};
+
+// Capture state machine. Only ever touched by LokiWorker's audio thread;
+// finished utterances leave it through the transcription stage's queue.
 struct AppData {
-    std::mutex mtx;
-    pv_porcupine_t *porcupine = nullptr;
+    loki::core::WakeWordDetector *wake_word = nullptr;
     Whisper *whisper = nullptr;
     AppState state = AppState::LISTENING_FOR_WAKE_WORD;
-    std::vector<int16_t> porcupine_buffer;
     std::vector<float> command_buffer;
-    int consecutive_silent_frames = 0;
-    bool has_started_speaking = false;
-    float vad_threshold = 0.01f;
+    loki::core::PreRollBuffer pre_roll; // Always-on history spliced in front of each command
+    loki::core::Endpointer *endpointer = nullptr; // Decides when the command has ended
     LokiWorker *worker = nullptr;
+    loki::core::AudioRingBuffer *capture_ring = nullptr; // Written only by data_callback
+    loki::core::PipelineStage<CapturedUtterance> *transcription_stage = nullptr;
+    loki::core::StreamingTranscriber *streaming = nullptr; // Optional
+    std::shared_ptr<loki::core::StreamingTranscriber::Session> stream_session;
 };
 
 // --- MINIAUDIO PLAYBACK ---
@@ -114,52 +127,61 @@ void memory_playback_data_callback(ma_device *pDevice, void *pOutput, const void
 
 // --- END MINIAUDIO PLAYBACK ---
 
+// Runs on the real-time audio thread: it only copies samples into the capture ring.
+// The ring wakes the wake word thread itself if, and only if, it is waiting.
 void data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
     auto *pData = static_cast<AppData *>(pDevice->pUserData);
-    if (pData == nullptr) return;
-    bool wake_word_was_detected = false;
-    std::lock_guard<std::mutex> lock(pData->mtx);
-    const auto *samples_f32 = static_cast<const float *>(pInput);
+    if (pData == nullptr || pData->capture_ring == nullptr) return;
+    pData->capture_ring->write(static_cast<const float *>(pInput), frameCount);
+}
 
+// Runs on LokiWorker's audio thread for every wake-word-sized frame drained from the
+// capture ring. Returns true if the wake word was detected in this frame.
+bool process_capture_chunk(AppData *pData, const float *samples_f32, size_t frameCount, size_t backlog_frames) {
     if (pData->state == AppState::RECORDING_COMMAND) {
-        double sum_squares = 0.0;
-        for (size_t i = 0; i < frameCount; ++i) {
-            sum_squares += samples_f32[i] * samples_f32[i];
-        }
-        double rms = std::sqrt(sum_squares / frameCount);
-
         pData->command_buffer.insert(pData->command_buffer.end(), samples_f32, samples_f32 + frameCount);
-        if (rms < pData->vad_threshold) {
-            pData->consecutive_silent_frames++;
-        } else {
-            pData->has_started_speaking = true;
-            pData->consecutive_silent_frames = 0;
+        if (pData->stream_session) {
+            pData->streaming->feed(pData->stream_session, samples_f32, frameCount);
         }
-
-        constexpr int SILENT_FRAMES_AFTER_SPEECH = 40;
-        constexpr int SILENT_FRAMES_NO_SPEECH = 100;
-        if ((pData->has_started_speaking && pData->consecutive_silent_frames > SILENT_FRAMES_AFTER_SPEECH) ||
-            (!pData->has_started_speaking && pData->consecutive_silent_frames > SILENT_FRAMES_NO_SPEECH)) {
-            pData->state = AppState::PROCESSING_COMMAND;
+        if (pData->endpointer->process(samples_f32, frameCount)) {
+            // End of speech: drop the silence around it and hand the utterance
+            // straight to the transcription stage. The stream session holds the
+            // same samples as the command buffer, so it is clipped to the same range.
+            if (pData->stream_session) {
+                size_t start = 0, end = 0;
+                if (pData->endpointer->trim_bounds(pData->command_buffer.size(), start, end)) {
+                    pData->streaming->clip(pData->stream_session, start, end);
+                }
+                pData->streaming->end(pData->stream_session);
+            }
+            pData->endpointer->trim(pData->command_buffer);
+            CapturedUtterance utterance{std::move(pData->command_buffer), std::move(pData->stream_session)};
+            if (!pData->transcription_stage->try_submit(std::move(utterance))) {
+                std::cerr << "WARNING: Transcription queue full, dropping utterance." << std::endl;
+            }
+            pData->command_buffer = {};
+            pData->stream_session.reset();
+            pData->state = AppState::LISTENING_FOR_WAKE_WORD;
         }
     } else if (pData->state == AppState::LISTENING_FOR_WAKE_WORD) {
-        pData->porcupine_buffer.resize(frameCount);
-        for (ma_uint32 i = 0; i < frameCount; ++i) {
-            pData->porcupine_buffer[i] = static_cast<int16_t>(samples_f32[i] * 32767.0f);
-        }
-        int32_t keyword_index;
-        pv_porcupine_process(pData->porcupine, pData->porcupine_buffer.data(), &keyword_index);
-        if (keyword_index != -1) {
+        // Feed the pre-roll before running Porcupine so the frame containing the
+        // end of the wake word (and anything said with it) is part of the command.
+        pData->pre_roll.push(samples_f32, frameCount);
+        if (pData->wake_word->process(samples_f32, backlog_frames)) {
             pData->state = AppState::RECORDING_COMMAND;
             pData->command_buffer.clear();
-            pData->consecutive_silent_frames = 0;
-            pData->has_started_speaking = false;
-            wake_word_was_detected = true;
+            pData->pre_roll.copy_to(pData->command_buffer);
+            pData->pre_roll.clear();
+            if (pData->streaming) {
+                pData->stream_session = pData->streaming->begin();
+                pData->streaming->feed(pData->stream_session, pData->command_buffer.data(),
+                                       pData->command_buffer.size());
+            }
+            pData->endpointer->reset(pData->command_buffer.size());
+            return true;
         }
     }
-    if (wake_word_was_detected) {
-        QMetaObject::invokeMethod(pData->worker, "wake_word_detected_signal", Qt::QueuedConnection);
-    }
+    return false;
 }
 
 // --- LokiWorker Method Implementations ---
@@ -170,13 +192,12 @@ LokiWorker::LokiWorker(QObject *parent) : QObject(parent) {
     device_ = std::make_unique<ma_device>();
     agent_manager_ = std::make_unique<AgentManager>();
     app_data_->worker = this;
-
-    processing_timer_ = new QTimer(this);
-    connect(processing_timer_, &QTimer::timeout, this, &LokiWorker::check_for_command);
 }
 
 LokiWorker::~LokiWorker() {
     stop_processing();
+    // The streaming thread calls into the classifiers, so stop it before they go.
+    streaming_.reset();
 
     // Shutdown async TTS
     if (async_tts_) {
@@ -187,9 +208,6 @@ LokiWorker::~LokiWorker() {
         // Check if device was initialized
         ma_device_uninit(device_.get());
     }
-    if (porcupine_) {
-        pv_porcupine_delete(porcupine_);
-    }
     std::cout << "LokiWorker destroyed." << std::endl;
 }
 
@@ -197,17 +215,8 @@ void LokiWorker::initialize() {
     emit status_updated("Initializing...");
 
     std::filesystem::path app_dir(QCoreApplication::applicationDirPath().toStdString());
-    auto resolve_path = [&](const std::string &config_key, const std::string &default_val) -> std::string {
-        std::string path_str = config_->get(config_key, default_val);
-        std::filesystem::path p(path_str);
-        if (p.is_absolute()) {
-            if (std::filesystem::exists(p)) return p.string();
-            std::cerr << "WARNING: Absolute path from config for '" << config_key << "' not found: " << p <<
-                    ". Falling back to app directory." << std::endl;
-            p = std::filesystem::path(config_->get(config_key, default_val));
-        }
-        return (app_dir / p).string();
-    };
+    // Model and data paths in .env are relative to the executable's directory.
+    config_->set_base_dir(app_dir.string());
 
     const std::string ACCESS_KEY = config_->get("ACCESS_KEY", "");
     if (ACCESS_KEY.empty()) {
@@ -216,30 +225,34 @@ void LokiWorker::initialize() {
         return;
     }
 
-    const std::string PORCUPINE_MODEL_PATH = resolve_path("PORCUPINE_MODEL_PATH", "porcupine_params.pv");
-    const std::string KEYWORD_PATH = resolve_path("KEYWORD_PATH", "Hey-Loki.ppn");
-    const std::string WHISPER_MODEL_PATH = resolve_path("WHISPER_MODEL_PATH", "ggml-base.en.bin");
-    const std::string EMBEDDING_MODEL_PATH = resolve_path("EMBEDDING_MODEL_PATH", "all-MiniLM-L6-v2.Q4_K_S.gguf");
-    const std::string INTENTS_JSON_PATH = resolve_path("INTENTS_JSON_PATH", "intents.json");
+    const std::string PORCUPINE_MODEL_PATH = config_->get_path("PORCUPINE_MODEL_PATH", "porcupine_params.pv");
+    const std::string KEYWORD_PATH = config_->get_path("KEYWORD_PATH", "Hey-Loki.ppn");
+    const std::string WHISPER_MODEL_PATH = config_->get_path("WHISPER_MODEL_PATH", "ggml-base.en.bin");
+    const std::string EMBEDDING_MODEL_PATH = config_->get_path("EMBEDDING_MODEL_PATH", "all-MiniLM-L6-v2.Q4_K_S.gguf");
+    const std::string INTENTS_JSON_PATH = config_->get_path("INTENTS_JSON_PATH", "intents.json");
     const float SENSITIVITY = config_->get_float("SENSITIVITY", 0.5f);
     min_command_ms_ = std::stoi(config_->get("MIN_COMMAND_MS", "300"));
-    app_data_->vad_threshold = config_->get_float("VAD_THRESHOLD", 0.01f);
+    const int CAPTURE_RING_MS = std::stoi(config_->get("CAPTURE_RING_MS", "2000"));
+    const int PRE_ROLL_MS = std::stoi(config_->get("PRE_ROLL_MS", "300"));
     const std::string OLLAMA_HOST = config_->get("OLLAMA_HOST", "http://localhost:11434");
     const std::string OLLAMA_MODEL = config_->get("OLLAMA_MODEL", "dolphin-phi");
 
     emit status_updated("Initializing Porcupine...");
-    const char *keyword_path_c_str = KEYWORD_PATH.c_str();
-    pv_status_t porcupine_status = pv_porcupine_init(ACCESS_KEY.c_str(), PORCUPINE_MODEL_PATH.c_str(), 1,
-                                                     &keyword_path_c_str, &SENSITIVITY, &porcupine_);
-    if (porcupine_status != PV_STATUS_SUCCESS) {
-        emit status_updated(QString("Porcupine init failed: %1").arg(pv_status_to_string(porcupine_status)));
+    std::string porcupine_error;
+    wake_word_ = loki::core::WakeWordDetector::create(ACCESS_KEY, PORCUPINE_MODEL_PATH, KEYWORD_PATH, SENSITIVITY,
+                                                      porcupine_error);
+    if (!wake_word_) {
+        emit status_updated(QString("Porcupine init failed: %1").arg(QString::fromStdString(porcupine_error)));
         emit initialization_complete();
         return;
     }
-    app_data_->porcupine = porcupine_;
+    app_data_->wake_word = wake_word_.get();
 
     emit status_updated("Initializing Whisper...");
-    whisper_ = Whisper::create(WHISPER_MODEL_PATH);
+    // One model, several decoder states: utterances transcribe in parallel on the
+    // "stt" stage (one worker per state) without loading the weights twice.
+    whisper_states_ = std::max(1, std::stoi(config_->get("WHISPER_STATES", "1")));
+    whisper_ = Whisper::create(WHISPER_MODEL_PATH, whisper_states_);
     if (!whisper_) {
         emit status_updated("ERROR: Failed to load Whisper model!");
         emit initialization_complete();
@@ -250,10 +263,10 @@ void LokiWorker::initialize() {
     // UPDATED: Initialize Async TTS system
     std::cout << "LOKI_WORKER_LOG: About to initialize Async TTS..." << std::endl;
     emit status_updated("Initializing TTS...");
-    std::string espeakDataAbsPath = resolve_path("ESPEAK_DATA_PATH", "espeak-ng-data");
+    std::string espeakDataAbsPath = config_->get_path("ESPEAK_DATA_PATH", "espeak-ng-data");
     SetEnvironmentVariableA("ESPEAK_DATA_PATH", espeakDataAbsPath.c_str());
     std::string piper_exe_path = (app_dir / "piper.exe").string();
-    std::string piper_model_path = resolve_path("PIPER_MODEL_PATH", "models/piper/en_US-hfc_male-medium.onnx");
+    std::string piper_model_path = config_->get_path("PIPER_MODEL_PATH", "models/piper/en_US-hfc_male-medium.onnx");
 
     async_tts_ = std::make_unique<loki::tts::AsyncTTSManager>(
         piper_exe_path, piper_model_path, app_dir.string(), this);
@@ -285,21 +298,77 @@ void LokiWorker::initialize() {
     }
 
     emit status_updated("Initializing Classifiers...");
-    fast_classifier_ = std::make_unique<loki::intent::FastClassifier>(INTENTS_JSON_PATH, *embedding_model_);
+    const auto classifier_options = loki::intent::FastClassifier::Options::from_config(*config_);
+    fast_classifier_ = std::make_unique<loki::intent::FastClassifier>(INTENTS_JSON_PATH, *embedding_model_,
+                                                                      classifier_options);
     nlohmann::json llm_options = {
         {"num_ctx", 1024}, {"temperature", 0.0}, {"top_k", 1}, {"top_p", 1.0}, {"max_new_tokens", 128}
     };
-    ollama_client_ = std::make_unique<loki::core::OllamaClient>(OLLAMA_HOST, OLLAMA_MODEL, llm_options);
-    llm_classifier_ = std::make_unique<loki::intent::IntentClassifier>(*ollama_client_);
+    // LLM_BACKEND=llama runs the model in-process from LLM_MODEL_PATH instead of
+    // calling the Ollama server; if it can't be loaded we fall back to Ollama.
+    if (config_->get("LLM_BACKEND", "ollama") == "llama") {
+        emit status_updated("Loading in-process LLM...");
+        auto llama_options = loki::core::LlamaBackendOptions::from_config(*config_);
+        llama_options.n_ctx = llm_options["num_ctx"].get<uint32_t>();
+        llama_options.max_tokens = llm_options["max_new_tokens"].get<int>();
+        llm_backend_ = loki::core::LlamaBackend::create(config_->get_path("LLM_MODEL_PATH", "llm.gguf"), llama_options);
+        if (!llm_backend_) {
+            emit status_updated("WARNING: Could not load LLM_MODEL_PATH, using Ollama instead.");
+        }
+    }
+    if (!llm_backend_) {
+        llm_backend_ = std::make_unique<loki::core::OllamaClient>(OLLAMA_HOST, OLLAMA_MODEL, llm_options,
+                                                                  config_->get("OLLAMA_KEEP_ALIVE", "30m"));
+    }
+    std::cout << "LOKI_WORKER_LOG: LLM backend: " << llm_backend_->get_name() << std::endl;
+    llm_classifier_ = std::make_unique<loki::intent::IntentClassifier>(
+        *llm_backend_, config_->get("LLM_GRAMMAR", "1") == "1");
+    speculative_llm_ = config_->get("LLM_SPECULATIVE", "0") == "1";
+    const auto semantic_options = loki::intent::SemanticIntentCache::Options::from_config(*config_);
+    if (semantic_options.capacity > 0) {
+        semantic_cache_ = std::make_unique<loki::intent::SemanticIntentCache>(
+            *fast_classifier_, embedding_model_->model_hash(), semantic_options);
+    }
     agent_manager_->register_agent(std::make_unique<SystemControlAgent>());
     agent_manager_->register_agent(std::make_unique<CalculationAgent>());
 
+    if (config_->get("STREAMING_STT", "0") == "1") {
+        emit status_updated("Initializing streaming transcription...");
+        loki::core::StreamingTranscriber::Options stream_options;
+        stream_options.sample_rate = wake_word_->sample_rate();
+        stream_options.step_ms = std::stoi(config_->get("STREAMING_STEP_MS", "1000"));
+        stream_options.window_ms = std::stoi(config_->get("STREAMING_WINDOW_MS", "8000"));
+        streaming_ = loki::core::StreamingTranscriber::create(*whisper_, stream_options,
+                                                              [this](const std::string &partial) {
+                                                                  on_partial_transcript(partial);
+                                                              });
+        app_data_->streaming = streaming_.get();
+    }
+
     emit status_updated("Initializing Audio Device...");
+    capture_ring_ = std::make_unique<loki::core::AudioRingBuffer>(
+        static_cast<size_t>(wake_word_->sample_rate()) * CAPTURE_RING_MS / 1000);
+    if (!capture_ring_->can_block()) {
+        emit status_updated("WARNING: Capture wakeup unavailable, the audio thread will poll.");
+    }
+    app_data_->capture_ring = capture_ring_.get();
+    app_data_->pre_roll = loki::core::PreRollBuffer(
+        static_cast<size_t>(wake_word_->sample_rate()) * std::max(PRE_ROLL_MS, 0) / 1000);
+
+    // End-of-speech detection: Silero VAD if configured, otherwise the RMS threshold.
+    endpointer_ = loki::core::Endpointer::create(*config_, wake_word_->sample_rate());
+    if (config_->get("VAD_BACKEND", "rms") == "silero" && endpointer_->get_name() != "silero") {
+        emit status_updated("WARNING: Silero VAD unavailable, falling back to RMS endpointing.");
+    }
+    app_data_->endpointer = endpointer_.get();
+    std::cout << "LOKI_WORKER_LOG: Using '" << endpointer_->get_name() << "' endpointer with "
+            << endpointer_->options().hangover_ms << " ms hangover." << std::endl;
+
     ma_device_config deviceConfig = ma_device_config_init(ma_device_type_capture);
     deviceConfig.capture.format = ma_format_f32;
     deviceConfig.capture.channels = 1;
-    deviceConfig.sampleRate = pv_sample_rate();
-    deviceConfig.periodSizeInFrames = pv_porcupine_frame_length();
+    deviceConfig.sampleRate = wake_word_->sample_rate();
+    deviceConfig.periodSizeInFrames = static_cast<ma_uint32>(wake_word_->frame_length());
     deviceConfig.dataCallback = data_callback;
     deviceConfig.pUserData = app_data_.get();
     if (ma_device_init(nullptr, &deviceConfig, device_.get()) != MA_SUCCESS) {
@@ -313,91 +382,306 @@ void LokiWorker::initialize() {
 }
 
 void LokiWorker::start_processing() {
+    if (!capture_ring_) {
+        emit status_updated("ERROR: Audio capture is not initialized.");
+        return;
+    }
+    // Each stage runs on its own thread, so a new utterance can be transcribed
+    // and classified while the previous response is still being spoken.
+    speech_stage_ = std::make_unique<loki::core::PipelineStage<std::string> >(
+        "tts", STAGE_QUEUE_CAPACITY, 1, [this](std::string text) { run_speech(std::move(text)); });
+    agent_stage_ = std::make_unique<loki::core::PipelineStage<loki::intent::Intent> >(
+        "agent", STAGE_QUEUE_CAPACITY, 1, [this](loki::intent::Intent intent) { run_agent(std::move(intent)); });
+    intent_stage_ = std::make_unique<loki::core::PipelineStage<std::string> >(
+        "intent", STAGE_QUEUE_CAPACITY, 1, [this](std::string text) { run_intent(std::move(text)); });
+    transcription_stage_ = std::make_unique<loki::core::PipelineStage<CapturedUtterance> >(
+        "stt", STAGE_QUEUE_CAPACITY, static_cast<size_t>(whisper_states_),
+        [this](CapturedUtterance utterance) { run_transcription(std::move(utterance)); });
+    speech_stage_->start();
+    agent_stage_->start();
+    intent_stage_->start();
+    transcription_stage_->start();
+    app_data_->transcription_stage = transcription_stage_.get();
+
+    audio_wakeups_ = 0;
+    audio_idle_wakeups_ = 0;
+    audio_thread_running_.store(true);
+    audio_thread_ = std::thread(&LokiWorker::audio_thread_loop, this);
+
     if (ma_device_start(device_.get()) != MA_SUCCESS) {
         emit status_updated("ERROR: Failed to start capture device.");
+        stop_processing();
         return;
     }
-    processing_timer_->start(50);
+    processing_started_ = std::chrono::steady_clock::now();
     emit status_updated("Waiting for wake word ('Hey Loki')...");
 }
 
 void LokiWorker::stop_processing() {
-    if (processing_timer_->isActive()) {
-        processing_timer_->stop();
+    if (device_ && device_->pUserData && ma_device_is_started(device_.get())) {
+        ma_device_stop(device_.get());
+    }
+    audio_thread_running_.store(false);
+    if (audio_thread_.joinable()) {
+        // The device is stopped, so no write will wake the thread; do it so it sees the flag.
+        capture_ring_->interrupt();
+        audio_thread_.join();
+        std::cout << "LOKI_WORKER_LOG: Capture ring stats: " << capture_ring_->frames_written() << " frames, "
+                << capture_ring_->dropped_frames() << " dropped, " << capture_ring_->overruns() << " overruns."
+                << std::endl;
+        const double audio_uptime_s = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - processing_started_).count();
+        std::cout << "LOKI_WORKER_LOG: Audio thread: " << audio_wakeups_ << " wakeups ("
+                << audio_idle_wakeups_ << " idle), "
+                << (audio_uptime_s > 0.0 ? audio_wakeups_ / audio_uptime_s : 0.0) << " per second." << std::endl;
+        const auto ww = wake_word_->stats();
+        std::cout << "LOKI_WORKER_LOG: Wake word stats: " << ww.detections << " detections in "
+                << ww.frames_processed << " frames, max backlog " << ww.max_backlog_frames
+                << " frames, slowest frame " << ww.max_process_ms << " ms." << std::endl;
     }
-}
 
-void LokiWorker::check_for_command() {
-    std::vector<float> audio_to_process;
-    bool ready_to_process = false; {
-        std::lock_guard<std::mutex> lock(app_data_->mtx);
-        if (app_data_->state == AppState::PROCESSING_COMMAND) {
-            ready_to_process = true;
-            audio_to_process = std::move(app_data_->command_buffer);
-            app_data_->state = AppState::LISTENING_FOR_WAKE_WORD;
+    // Stop upstream first so every stage drains into a still-running successor,
+    // then report how often the stages woke up (the old 50 ms poll woke 20 times a second).
+    if (transcription_stage_) {
+        transcription_stage_->stop();
+        intent_stage_->stop();
+        agent_stage_->stop();
+        speech_stage_->stop();
+        const double uptime_s = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - processing_started_).count();
+        std::cout << "LOKI_WORKER_LOG: Pipeline stopped after " << uptime_s << " s." << std::endl;
+        log_pipeline_stats();
+        const auto lru = fast_classifier_->transcript_cache_stats();
+        std::cout << "LOKI_WORKER_LOG: Transcript embedding cache: " << lru.hits << " hits, " << lru.misses
+                << " misses, " << lru.evictions << " evictions (" << lru.size << "/" << lru.capacity << ")."
+                << std::endl;
+        const auto lexical = fast_classifier_->lexical_stats();
+        std::cout << "LOKI_WORKER_LOG: Lexical fast path: " << lexical.exact_hits << " exact and "
+                << lexical.stripped_hits << " stopword-stripped hits in " << lexical.lookups << " lookups."
+                << std::endl;
+        const auto learning = fast_classifier_->learning_stats();
+        if (learning.learned_prompts > 0 || learning.learned + learning.rejected > 0) {
+            std::cout << "LOKI_WORKER_LOG: Intent learning: " << learning.learned << " prompts learned, "
+                    << learning.duplicates << " duplicates, " << learning.capped << " over the per-intent cap, "
+                    << learning.rejected << " rejected; " << learning.learned_prompts << " learned prompts in use."
+                    << std::endl;
+        }
+        const auto llm = llm_backend_->stats();
+        if (llm.requests > 0) {
+            std::cout << "LOKI_WORKER_LOG: LLM (" << llm_backend_->get_name() << "): " << llm.requests << " requests, " << llm.stopped_early
+                    << " stopped after the JSON object, mean first token "
+                    << (llm.first_tokens ? llm.first_token_ms_total / llm.first_tokens : 0.0)
+                    << " ms, mean complete JSON "
+                    << (llm.json_completed ? llm.json_complete_ms_total / llm.json_completed : 0.0) << " ms."
+                    << std::endl;
+            if (llm.prompt_evals > 0) {
+                std::cout << "LOKI_WORKER_LOG: LLM prompt evaluation: mean "
+                        << llm.prompt_eval_ms_total / llm.prompt_evals << " ms, "
+                        << llm.prompt_tokens_evaluated_total / llm.prompt_evals << " tokens evaluated per request";
+                if (llm.prompt_tokens_total > 0) {
+                    std::cout << " of " << llm.prompt_tokens_total / llm.prompt_evals;
+                }
+                std::cout << ", " << llm.prompt_prefix_losses << " re-evaluated a lost prefix." << std::endl;
+            }
+            const auto parse = llm_classifier_->parse_stats();
+            std::cout << "LOKI_WORKER_LOG: LLM answers: " << parse.failures << " of " << parse.responses
+                    << " failed to parse (" << llm.constrained << " requests grammar-constrained)." << std::endl;
         }
+        if (semantic_cache_) {
+            const auto cache = semantic_cache_->stats();
+            std::cout << "LOKI_WORKER_LOG: Semantic LLM cache: " << cache.hits << " hits (" << cache.exact_hits
+                    << " exact) in " << cache.lookups << " lookups, " << cache.rejected
+                    << " rejected on parameters, " << cache.expired << " expired, " << cache.evictions
+                    << " evictions (" << cache.size << "/" << cache.capacity << ")." << std::endl;
+            semantic_cache_->save();
+        }
+        if (speculative_llm_) {
+            const auto spec = llm_classifier_->speculation_stats();
+            std::cout << "LOKI_WORKER_LOG: Speculative LLM: " << spec.started << " started, " << spec.used
+                    << " used, " << spec.cancelled << " cancelled, " << spec.discarded << " discarded." << std::endl;
+        }
+        const auto pool = whisper_->pool_stats();
+        std::cout << "LOKI_WORKER_LOG: Whisper state pool: " << pool.leases << " leases on " << pool.size
+                << " state(s), " << pool.waits << " waited (" << pool.wait_ms << " ms total)." << std::endl;
+        if (streaming_) {
+            const auto st = streaming_->stats();
+            std::cout << "LOKI_WORKER_LOG: Streaming STT: " << st.partial_decodes << " partial decodes, "
+                    << st.final_decodes << " final decodes, " << st.final_decodes_skipped
+                    << " finals covered by the last partial." << std::endl;
+        }
+        app_data_->transcription_stage = nullptr;
+        transcription_stage_.reset();
+        intent_stage_.reset();
+        agent_stage_.reset();
+        speech_stage_.reset();
     }
+}
 
-    if (ready_to_process) {
-        emit status_updated("Silence detected, processing...");
-        const int audio_ms = static_cast<int>(audio_to_process.size() * 1000 / pv_sample_rate());
-
-        if (audio_ms > min_command_ms_) {
-            std::string transcription = app_data_->whisper->process_audio(audio_to_process);
-            if (transcription.empty()) {
-                emit status_updated("Heard nothing.");
-            } else {
-                emit status_updated(QString("Heard: \"%1\"").arg(QString::fromStdString(transcription)));
-                auto fast_result = fast_classifier_->classify(transcription);
-                loki::intent::Intent intent;
-
-                if (fast_result.has_match && fast_result.confidence >= 0.95f) {
-                    emit status_updated("Fast path hit! Routing directly.");
-                    intent = {fast_result.type, fast_result.action, fast_result.parameters, fast_result.confidence};
-                } else {
-                    emit status_updated("Fast path miss. Falling back to LLM...");
-                    intent = llm_classifier_->classify(transcription);
-                }
+std::vector<loki::core::PipelineStageStats> LokiWorker::pipeline_stats() const {
+    if (!transcription_stage_) return {};
+    return {
+        transcription_stage_->stats(), intent_stage_->stats(), agent_stage_->stats(), speech_stage_->stats()
+    };
+}
 
-                // UPDATED: Use async TTS system
-                auto handle_response = [this](const std::string &text) {
-                    if (text.empty()) return;
-                    emit loki_response(QString::fromStdString(text));
-
-                    if (async_tts_ && async_tts_->isReady()) {
-                        // Use async synthesis with callback
-                        async_tts_->synthesizeAsync(
-                            QString::fromStdString(text),
-                            [this](bool success, const std::vector<char> &audioData, const QString &error) {
-                                if (success) {
-                                    std::cout << "LOKI_WORKER_LOG: TTS synthesis successful, playing audio..." <<
-                                            std::endl;
-                                    play_audio_from_memory(audioData);
-                                } else {
-                                    emit status_updated(QString("TTS Error: %1").arg(error));
-                                    std::cout << "LOKI_WORKER_LOG: TTS synthesis failed: " << error.toStdString() <<
-                                            std::endl;
-                                }
-                            },
-                            loki::tts::TTSPriority::HIGH
-                        );
-                    } else {
-                        emit status_updated("TTS not ready, skipping playback.");
-                        std::cout << "LOKI_WORKER_LOG: TTS not ready for synthesis" << std::endl;
-                    }
-                };
-
-                if (intent.confidence >= 0.7) {
-                    std::string response = agent_manager_->dispatch(intent);
-                    handle_response(response);
-                } else {
-                    handle_response("I'm not very confident about that. Could you please rephrase?");
-                }
+void LokiWorker::log_pipeline_stats() const {
+    std::cout << "LOKI_WORKER_LOG: Pipeline";
+    for (const auto &s: pipeline_stats()) {
+        std::cout << " | " << s.name << ": queue " << s.queue_depth << "/" << s.queue_capacity
+                << ", busy " << s.busy_workers << "/" << s.workers
+                << ", done " << s.processed << " (" << s.busy_ms << " ms)"
+                << ", wakeups " << s.wakeups << " (" << s.idle_wakeups << " idle)";
+    }
+    std::cout << std::endl;
+}
+
+void LokiWorker::audio_thread_loop() {
+    // Porcupine needs exactly frame_length() samples per call, so the ring is
+    // drained in whole frames regardless of the device's actual period size.
+    const size_t chunk_frames = wake_word_->frame_length();
+    // When the ring is short, sleep until the callback's next write. The ring
+    // only signals while this thread is waiting, so draining a backlog costs no
+    // wakeups; one that still finds less than a frame is idle. The timeout only
+    // matters if the device stops delivering.
+    const auto max_wait = std::chrono::milliseconds(AUDIO_WAIT_TIMEOUT_MS);
+    std::vector<float> chunk(chunk_frames);
+    uint64_t reported_drops = 0;
+
+    while (audio_thread_running_.load()) {
+        if (capture_ring_->available() < chunk_frames) {
+            ++audio_wakeups_;
+            if (!capture_ring_->wait_for(chunk_frames, max_wait)) {
+                ++audio_idle_wakeups_;
             }
-        } else {
-            emit status_updated(QString("Command too short (%1ms).").arg(audio_ms));
+            continue;
+        }
+        capture_ring_->read(chunk.data(), chunk.size());
+        if (process_capture_chunk(app_data_.get(), chunk.data(), chunk.size(), capture_ring_->available())) {
+            const auto ww = wake_word_->stats();
+            std::cout << "LOKI_WORKER_LOG: Wake word detected (latency " << ww.last_latency_ms << " ms, backlog "
+                    << ww.last_backlog_frames << " frames)." << std::endl;
+            QMetaObject::invokeMethod(this, "wake_word_detected_signal", Qt::QueuedConnection);
+        }
+
+        const uint64_t drops = capture_ring_->dropped_frames();
+        if (drops != reported_drops) {
+            std::cerr << "WARNING: Capture ring overflowed, " << drops - reported_drops << " frames dropped."
+                    << std::endl;
+            reported_drops = drops;
+        }
+    }
+}
+
+void LokiWorker::run_transcription(CapturedUtterance utterance) {
+    emit status_updated("Silence detected, processing...");
+    log_pipeline_stats();
+    const int audio_ms = static_cast<int>(utterance.audio.size() * 1000 / wake_word_->sample_rate());
+    if (audio_ms <= min_command_ms_) {
+        if (utterance.stream) {
+            streaming_->end(utterance.stream);
+        }
+        emit status_updated(QString("Command too short (%1ms).").arg(audio_ms));
+        return;
+    }
+
+    // With streaming enabled most of the audio has already been decoded while
+    // the user was speaking; only the last window is left.
+    std::string transcription = utterance.stream
+                                    ? streaming_->finish(utterance.stream)
+                                    : app_data_->whisper->process_audio(utterance.audio);
+    if (transcription.empty()) {
+        emit status_updated("Heard nothing.");
+        return;
+    }
+    emit status_updated(QString("Heard: \"%1\"").arg(QString::fromStdString(transcription)));
+    intent_stage_->submit(std::move(transcription));
+}
+
+void LokiWorker::on_partial_transcript(const std::string &partial) {
+    emit status_updated(QString("Hearing: \"%1\"...").arg(QString::fromStdString(partial)));
+
+    // Classify the partial right away; if the final transcript turns out to be
+    // the same text the intent stage can skip the embedding entirely.
+    auto fast_result = fast_classifier_->classify(partial);
+    std::shared_ptr<const loki::intent::Intent> early;
+    if (fast_result.has_match && fast_result.confidence >= 0.95f) {
+        early = std::make_shared<const loki::intent::Intent>(loki::intent::Intent{
+            fast_result.type, fast_result.action, fast_result.parameters, fast_result.confidence
+        });
+    }
+    std::lock_guard<std::mutex> lock(early_intent_mtx_);
+    early_intent_text_ = partial;
+    early_intent_ = std::move(early);
+}
+
+void LokiWorker::run_intent(std::string transcription) {
+    std::shared_ptr<const loki::intent::Intent> early; {
+        std::lock_guard<std::mutex> lock(early_intent_mtx_);
+        if (early_intent_text_ == transcription) {
+            early = early_intent_;
         }
     }
+    if (early) {
+        emit status_updated("Fast path hit on partial transcript! Routing directly.");
+        agent_stage_->submit(*early);
+        return;
+    }
+
+    // With LLM_SPECULATIVE=1 the LLM request goes out before the embedding
+    // search rather than after it, and is cancelled if the fast path hits.
+    // Exact prompt matches never need it, so they're checked first.
+    std::unique_ptr<loki::intent::IntentClassifier::Speculation> speculation;
+    auto fast_result = fast_classifier_->classify_lexical(transcription);
+    if (!fast_result.has_match) {
+        if (speculative_llm_) {
+            speculation = llm_classifier_->classify_speculative(transcription);
+        }
+        fast_result = fast_classifier_->classify_embedding(transcription);
+    }
+    loki::intent::Intent intent;
+
+    if (fast_result.has_match && fast_result.confidence >= 0.95f) {
+        emit status_updated("Fast path hit! Routing directly.");
+        intent = {fast_result.type, fast_result.action, fast_result.parameters, fast_result.confidence};
+    } else if (semantic_cache_ && semantic_cache_->lookup(transcription, intent)) {
+        // A paraphrase of an earlier miss; the speculation, if any, is cancelled below.
+        emit status_updated("Semantic cache hit. Skipping the LLM.");
+    } else {
+        emit status_updated("Fast path miss. Falling back to LLM...");
+        intent = speculation ? speculation->get() : llm_classifier_->classify(transcription);
+        if (semantic_cache_) semantic_cache_->insert(transcription, intent);
+        agent_stage_->submit(intent);
+        // With INTENT_LEARN=1 a confident answer becomes a fast-path prompt, so
+        // the same command skips the LLM next time. Done after the submit so
+        // the agent doesn't wait on it.
+        fast_classifier_->learn(transcription, intent);
+        return;
+    }
+    agent_stage_->submit(std::move(intent));
+    // An unused speculation is cancelled here, after the intent is on its way.
+}
+
+void LokiWorker::run_agent(loki::intent::Intent intent) {
+    if (intent.confidence >= 0.7) {
+        speech_stage_->submit(agent_manager_->dispatch(intent));
+    } else {
+        speech_stage_->submit("I'm not very confident about that. Could you please rephrase?");
+    }
+}
+
+void LokiWorker::run_speech(std::string text) {
+    if (text.empty()) return;
+    emit loki_response(QString::fromStdString(text));
+
+    // synthesizeSync registers the request before queuing it and waits on a
+    // deadline, so it can block this stage's thread while the TTS manager
+    // delivers the result on the Qt thread. It must not run on the Qt thread.
+    std::vector<char> audio_data;
+    if (synthesize_text_sync(QString::fromStdString(text), audio_data, SPEECH_SYNTHESIS_TIMEOUT_MS)) {
+        play_audio_from_memory(audio_data);
+    } else {
+        emit status_updated("TTS failed or not ready, skipping playback.");
+    }
 }
 
 void LokiWorker::play_audio(const std::string &wav_path) {
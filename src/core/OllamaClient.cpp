@@ -1,6 +1,8 @@
 #include "loki/core/OllamaClient.h"
+#include "loki/core/JsonObjectScanner.h"
 #include "httplib/httplib.h"
 #include "nlohmann/json.hpp"
+#include <chrono>
 #include <iostream>
 
 using json = nlohmann::json;
@@ -28,8 +30,9 @@ namespace loki {
             }
         }
 
-        OllamaClient::OllamaClient(const std::string &host, const std::string &model_name, const json &options)
-            : model_name_(model_name), options_(options) {
+        OllamaClient::OllamaClient(const std::string &host, const std::string &model_name, const json &options,
+                                   const std::string &keep_alive)
+            : model_name_(model_name), options_(options), keep_alive_(keep_alive) {
             std::string address;
             int port;
             bool is_https;
@@ -53,55 +56,140 @@ namespace loki {
         OllamaClient::~OllamaClient() = default;
 
 
-        std::string OllamaClient::generate(const std::string &system_prompt, const std::string &user_prompt) {
+        // Maps the common httplib errors to something readable for the log.
+        static std::string describe_error(httplib::Error err) {
+            // httplib::to_string is not a public function, so we map common errors
+            if (err == httplib::Error::Connection) return "Connection error";
+            if (err == httplib::Error::Read) return "Read error";
+            if (err == httplib::Error::Write) return "Write error";
+            return "Unknown error";
+        }
+
+        json OllamaClient::make_payload(const std::string &system_prompt, const std::string &user_prompt,
+                                        const OutputFormat *format) const {
             json payload = {
                 {"model", model_name_},
                 {"system", system_prompt},
                 {"prompt", user_prompt},
-                {"stream", false}
+                {"stream", true}
             };
 
             if (!options_.is_null() && !options_.empty()) {
                 payload["options"] = options_;
             }
+            if (!keep_alive_.empty()) {
+                payload["keep_alive"] = keep_alive_;
+            }
+            // Ollama turns a JSON schema in "format" into a sampling grammar.
+            if (format && !format->json_schema.empty()) {
+                payload["format"] = json::parse(format->json_schema, nullptr, false);
+                if (payload["format"].is_discarded()) payload.erase("format");
+            }
+            return payload;
+        }
+
+        std::string OllamaClient::generate_impl(const std::string &system_prompt, const std::string &user_prompt,
+                                                const std::atomic<bool> *cancelled, bool stop_after_json,
+                                                const OutputFormat *format) {
+            httplib::Request req;
+            req.method = "POST";
+            req.path = "/api/generate";
+            req.set_header("Content-Type", "application/json");
+            const json payload = make_payload(system_prompt, user_prompt, format);
+            req.body = payload.dump();
+
+            const auto start = std::chrono::steady_clock::now();
+            auto elapsed_ms = [&start] {
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+            auto is_cancelled = [cancelled] { return cancelled && cancelled->load(); };
+
+            // Ollama streams one JSON object per line, each carrying the next piece
+            // of "response". Returning false from the receiver aborts the request.
+            GenerateMetrics metrics;
+            metrics.constrained = payload.contains("format");
+            // Under a grammar the model has to stop right after the object, so
+            // letting it finish costs about one token and keeps the final stats chunk.
+            const bool stop_early = stop_after_json && !metrics.constrained;
+            JsonObjectScanner scanner;
+            std::string response;
+            std::string pending;
+            std::string error_msg;
+            bool json_done = false;
+            bool stream_done = false;
+            auto consume_line = [&](const std::string &line) {
+                json chunk = json::parse(line, nullptr, false);
+                if (chunk.is_discarded()) return;
+                if (chunk.contains("error")) {
+                    error_msg = chunk["error"].get<std::string>();
+                    return;
+                }
+                stream_done = chunk.value("done", false);
+                if (stream_done && chunk.contains("prompt_eval_duration")) {
+                    // Ollama skips the prefix it still has in the KV cache, so this
+                    // count drops to roughly the transcript once the model is warm.
+                    metrics.prompt_tokens_evaluated = chunk.value("prompt_eval_count", 0);
+                    metrics.prompt_eval_ms = chunk.value("prompt_eval_duration", 0.0) / 1e6;
+                }
+                const std::string piece = chunk.value("response", "");
+                if (piece.empty() || (json_done && stop_after_json)) return;
+                metrics.chunks++;
+                if (metrics.first_token_ms < 0.0) metrics.first_token_ms = elapsed_ms();
+                const size_t end = json_done ? std::string::npos : scanner.feed(piece);
+                if (end == std::string::npos) {
+                    response += piece;
+                    return;
+                }
+                // Anything after the object is dropped when we're about to stop anyway.
+                response.append(piece, 0, stop_after_json ? end : piece.size());
+                metrics.json_complete_ms = elapsed_ms();
+                json_done = true;
+            };
+            req.content_receiver = [&](const char *data, size_t data_length, uint64_t, uint64_t) {
+                if (is_cancelled()) return false;
+                pending.append(data, data_length);
+                size_t newline;
+                while ((newline = pending.find('\n')) != std::string::npos) {
+                    consume_line(pending.substr(0, newline));
+                    pending.erase(0, newline + 1);
+                }
+                if (json_done && stop_early && !stream_done) {
+                    metrics.stopped_early = true;
+                    return false;
+                }
+                return true;
+            };
 
+            if (is_cancelled()) return "";
+            auto res = client_->send(req);
+            metrics.total_ms = elapsed_ms();
+            if (is_cancelled()) return "";
+            if (res && !pending.empty()) {
+                consume_line(pending);
+                pending.clear();
+            }
+            record_metrics(metrics);
 
-            auto res = client_->Post("/api/generate", payload.dump(), "application/json");
+            // Aborting on purpose surfaces as a cancelled request; the answer is complete.
+            if (metrics.stopped_early) return response;
 
             if (!res) {
-                auto err = res.error();
-                std::string err_str = "Unknown error";
-                // httplib::to_string is not a public function, so we map common errors
-                if (err == httplib::Error::Connection) err_str = "Connection error";
-                else if (err == httplib::Error::Read) err_str = "Read error";
-                else if (err == httplib::Error::Write) err_str = "Write error";
-
-                std::cerr << "Ollama request failed: " << err_str << std::endl;
+                std::cerr << "Ollama request failed: " << describe_error(res.error()) << std::endl;
                 return "[Error: Could not connect to Ollama server]";
             }
-
+            if (!error_msg.empty()) {
+                std::cerr << "Ollama API error: " << error_msg << std::endl;
+                return "[Ollama Error: " + error_msg + "]";
+            }
             if (res->status != 200) {
                 std::cerr << "Ollama API returned status " << res->status << std::endl;
-                std::cerr << "Response body: " << res->body << std::endl;
                 return "[Error: Ollama API returned status " + std::to_string(res->status) + "]";
             }
+            return response;
+        }
 
-            try {
-                json response_json = json::parse(res->body);
-                if (response_json.contains("response")) {
-                    return response_json["response"].get<std::string>();
-                }
-                if (response_json.contains("error")) {
-                    std::string error_msg = response_json["error"].get<std::string>();
-                    std::cerr << "Ollama API error: " << error_msg << std::endl;
-                    return "[Ollama Error: " + error_msg + "]";
-                }
-            } catch (const json::parse_error &e) {
-                std::cerr << "Failed to parse Ollama JSON response: " << e.what() << std::endl;
-                return "[Error: Failed to parse Ollama response]";
-            }
-
-            return "[Error: Unknown response format from Ollama]";
+        void OllamaClient::cancel() {
+            client_->stop();
         }
     } // namespace core
 } // namespace loki
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "loki/core/PreRollBuffer.h"
+#include <algorithm>
+
+namespace loki {
+    namespace core {
+        PreRollBuffer::PreRollBuffer(size_t capacity_frames) : buffer_(capacity_frames) {
+        }
+
+        void PreRollBuffer::push(const float *frames, size_t count) {
+            const size_t capacity = buffer_.size();
+            if (capacity == 0) return;
+            // Only the newest `capacity` samples can survive.
+            if (count > capacity) {
+                frames += count - capacity;
+                count = capacity;
+            }
+            const size_t first = std::min(count, capacity - write_pos_);
+            std::copy(frames, frames + first, buffer_.begin() + write_pos_);
+            std::copy(frames + first, frames + count, buffer_.begin());
+            write_pos_ = (write_pos_ + count) % capacity;
+            size_ = std::min(size_ + count, capacity);
+        }
+
+        void PreRollBuffer::copy_to(std::vector<float> &out) const {
+            if (size_ == 0) return;
+            const size_t capacity = buffer_.size();
+            const size_t start = (write_pos_ + capacity - size_) % capacity;
+            const size_t first = std::min(size_, capacity - start);
+            out.insert(out.end(), buffer_.begin() + start, buffer_.begin() + start + first);
+            out.insert(out.end(), buffer_.begin(), buffer_.begin() + (size_ - first));
+        }
+
+        void PreRollBuffer::clear() {
+            write_pos_ = 0;
+            size_ = 0;
+        }
+    } // namespace core
+} // namespace loki
@@ -0,0 +1,175 @@
+#include "loki/core/StreamingTranscriber.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace loki {
+    namespace core {
+        static std::string trim(const std::string &s) {
+            auto start = s.find_first_not_of(" \t\n\r");
+            if (start == std::string::npos) return "";
+            auto end = s.find_last_not_of(" \t\n\r");
+            return s.substr(start, (end - start + 1));
+        }
+
+        std::unique_ptr<StreamingTranscriber> StreamingTranscriber::create(Whisper &whisper, const Options &options,
+                                                                           PartialCallback on_partial) {
+            Whisper::StatePtr state = whisper.create_state();
+            if (!state) {
+                std::cerr << "Error: failed to allocate a whisper_state for streaming transcription." << std::endl;
+                return nullptr;
+            }
+            return std::unique_ptr<StreamingTranscriber>(
+                new StreamingTranscriber(whisper, std::move(state), options, std::move(on_partial)));
+        }
+
+        StreamingTranscriber::StreamingTranscriber(Whisper &whisper, Whisper::StatePtr state, const Options &options,
+                                                   PartialCallback on_partial)
+            : whisper_(whisper), state_(std::move(state)), options_(options), on_partial_(std::move(on_partial)) {
+            thread_ = std::thread(&StreamingTranscriber::worker_loop, this);
+        }
+
+        StreamingTranscriber::~StreamingTranscriber() {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                running_ = false;
+            }
+            cv_.notify_all();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        std::shared_ptr<StreamingTranscriber::Session> StreamingTranscriber::begin() {
+            auto session = std::make_shared<Session>();
+            std::lock_guard<std::mutex> lock(mtx_);
+            active_ = session;
+            return session;
+        }
+
+        void StreamingTranscriber::feed(const std::shared_ptr<Session> &session, const float *samples,
+                                        size_t n_samples) {
+            const size_t step_samples = static_cast<size_t>(options_.sample_rate) * options_.step_ms / 1000;
+            bool wake = false;
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                session->audio.insert(session->audio.end(), samples, samples + n_samples);
+                wake = session == active_ && session->audio.size() >= session->decoded_samples + step_samples;
+            }
+            if (wake) {
+                cv_.notify_one();
+            }
+        }
+
+        void StreamingTranscriber::end(const std::shared_ptr<Session> &session) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            session->ended = true;
+            if (active_ == session) {
+                active_.reset();
+            }
+        }
+
+        void StreamingTranscriber::clip(const std::shared_ptr<Session> &session, size_t start, size_t end) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (end < session->audio.size()) {
+                session->audio.resize(end);
+            }
+            session->committed_samples = std::max(session->committed_samples, std::min(start, end));
+        }
+
+        std::vector<Whisper::Segment> StreamingTranscriber::decode_tail(const std::vector<float> &audio,
+                                                                        size_t from) {
+            if (from >= audio.size()) return {};
+            return whisper_.transcribe(state_.get(), audio.data() + from, audio.size() - from);
+        }
+
+        void StreamingTranscriber::worker_loop() {
+            const size_t step_samples = static_cast<size_t>(options_.sample_rate) * options_.step_ms / 1000;
+            const size_t window_samples = static_cast<size_t>(options_.sample_rate) * options_.window_ms / 1000;
+
+            std::unique_lock<std::mutex> lock(mtx_);
+            while (true) {
+                cv_.wait(lock, [&] {
+                    return !running_ || (active_ && !active_->ended &&
+                                         active_->audio.size() >= active_->decoded_samples + step_samples);
+                });
+                if (!running_) break;
+
+                std::shared_ptr<Session> session = active_;
+                const size_t from = session->committed_samples;
+                std::vector<float> audio = session->audio;
+                lock.unlock();
+
+                std::vector<Whisper::Segment> segments; {
+                    std::lock_guard<std::mutex> decode_lock(decode_mtx_);
+                    segments = decode_tail(audio, from);
+                }
+
+                lock.lock();
+                stats_.partial_decodes++;
+
+                // Once the uncommitted span is longer than the window, freeze every
+                // segment but the last so later decodes (and finish) start after it.
+                size_t first_uncommitted = 0;
+                if (audio.size() - from > window_samples && segments.size() > 1 &&
+                    session->committed_samples == from) {
+                    first_uncommitted = segments.size() - 1;
+                    for (size_t i = 0; i < first_uncommitted; ++i) {
+                        session->committed_text += segments[i].text;
+                    }
+                    const size_t commit_offset = static_cast<size_t>(
+                        segments[first_uncommitted - 1].t1_ms * options_.sample_rate / 1000);
+                    session->committed_samples = std::min(audio.size(), from + commit_offset);
+                }
+
+                std::string partial = session->committed_text;
+                for (size_t i = first_uncommitted; i < segments.size(); ++i) {
+                    partial += segments[i].text;
+                }
+                session->partial_text = trim(partial);
+                session->decoded_samples = audio.size();
+                partial = session->partial_text;
+
+                if (on_partial_ && !partial.empty()) {
+                    lock.unlock();
+                    on_partial_(partial);
+                    lock.lock();
+                }
+            }
+        }
+
+        std::string StreamingTranscriber::finish(const std::shared_ptr<Session> &session) {
+            const auto start = std::chrono::steady_clock::now();
+            end(session);
+
+            // Wait for any partial decode that is still running on this session.
+            std::lock_guard<std::mutex> decode_lock(decode_mtx_);
+            std::unique_lock<std::mutex> lock(mtx_);
+            // clip() can leave decoded_samples past the end of the trimmed audio.
+            if (session->decoded_samples >= session->audio.size() && !session->partial_text.empty()) {
+                stats_.final_decodes_skipped++;
+                return session->partial_text;
+            }
+
+            const size_t from = session->committed_samples;
+            std::string text = session->committed_text;
+            std::vector<float> audio = session->audio;
+            lock.unlock();
+
+            for (const auto &segment: decode_tail(audio, from)) {
+                text += segment.text;
+            }
+
+            lock.lock();
+            stats_.final_decodes++;
+            stats_.last_final_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            return trim(text);
+        }
+
+        StreamingTranscriber::Stats StreamingTranscriber::stats() const {
+            std::lock_guard<std::mutex> lock(mtx_);
+            return stats_;
+        }
+    } // namespace core
+} // namespace loki
@@ -0,0 +1,80 @@
+#include "loki/core/WakeWordDetector.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+extern "C" {
+#include "picovoice/include/pv_porcupine.h"
+}
+
+namespace loki {
+    namespace core {
+        std::unique_ptr<WakeWordDetector> WakeWordDetector::create(const std::string &access_key,
+                                                                   const std::string &model_path,
+                                                                   const std::string &keyword_path,
+                                                                   float sensitivity,
+                                                                   std::string &error) {
+            pv_porcupine_t *porcupine = nullptr;
+            const char *keyword_path_c_str = keyword_path.c_str();
+            pv_status_t status = pv_porcupine_init(access_key.c_str(), model_path.c_str(), 1,
+                                                   &keyword_path_c_str, &sensitivity, &porcupine);
+            if (status != PV_STATUS_SUCCESS) {
+                error = pv_status_to_string(status);
+                return nullptr;
+            }
+            return std::unique_ptr<WakeWordDetector>(new WakeWordDetector(porcupine));
+        }
+
+        WakeWordDetector::WakeWordDetector(pv_porcupine_t *porcupine)
+            : porcupine_(porcupine), pcm_(pv_porcupine_frame_length()) {
+        }
+
+        WakeWordDetector::~WakeWordDetector() {
+            if (porcupine_) {
+                pv_porcupine_delete(porcupine_);
+                porcupine_ = nullptr;
+            }
+        }
+
+        int WakeWordDetector::sample_rate() const {
+            return pv_sample_rate();
+        }
+
+        bool WakeWordDetector::process(const float *frame, size_t backlog_frames) {
+            for (size_t i = 0; i < pcm_.size(); ++i) {
+                const float clamped = std::clamp(frame[i], -1.0f, 1.0f);
+                pcm_[i] = static_cast<int16_t>(clamped * 32767.0f);
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            int32_t keyword_index = -1;
+            pv_status_t status = pv_porcupine_process(porcupine_, pcm_.data(), &keyword_index);
+            const double process_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            if (status != PV_STATUS_SUCCESS) {
+                std::cerr << "Porcupine process failed: " << pv_status_to_string(status) << std::endl;
+                return false;
+            }
+
+            const bool detected = keyword_index != -1;
+            std::lock_guard<std::mutex> lock(stats_mtx_);
+            stats_.frames_processed++;
+            stats_.max_process_ms = std::max(stats_.max_process_ms, process_ms);
+            stats_.max_backlog_frames = std::max(stats_.max_backlog_frames, backlog_frames);
+            if (detected) {
+                // The last sample of this frame was captured roughly `backlog_frames`
+                // samples ago; add the time Porcupine itself took.
+                stats_.detections++;
+                stats_.last_backlog_frames = backlog_frames;
+                stats_.last_latency_ms = backlog_frames * 1000.0 / pv_sample_rate() + process_ms;
+            }
+            return detected;
+        }
+
+        WakeWordDetector::Stats WakeWordDetector::stats() const {
+            std::lock_guard<std::mutex> lock(stats_mtx_);
+            return stats_;
+        }
+    } // namespace core
+} // namespace loki
@@ -9,56 +9,117 @@
 #include <string>
 #include <thread>
 #include <memory> // ADDED for std::unique_ptr
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 // The implementation class that holds the whisper_context and other details.
 class Whisper::WhisperImpl {
 private:
     whisper_context *ctx_ = nullptr;
+    int n_threads_ = 1;
+
+    // The pool. `states_` owns every state; `free_` holds the ones not leased.
+    std::vector<whisper_state *> states_;
+    std::vector<whisper_state *> free_;
+    mutable std::mutex pool_mtx_;
+    std::condition_variable pool_cv_;
+    Whisper::PoolStats stats_;
 
 public:
-    explicit WhisperImpl(const std::string &model_path) {
-        // Use the new, non-deprecated function to initialize
+    WhisperImpl(const std::string &model_path, int n_states) {
+        // Load only the weights; every decode runs on a state from the pool.
         struct whisper_context_params cparams = whisper_context_default_params();
-        ctx_ = whisper_init_from_file_with_params(model_path.c_str(), cparams);
+        ctx_ = whisper_init_from_file_with_params_no_state(model_path.c_str(), cparams);
 
         if (ctx_ == nullptr) {
             std::cerr << "Error: failed to initialize whisper model from: " << model_path << std::endl;
             return;
         }
-        std::cout << "Whisper initialized with model: " << model_path << std::endl;
+
+        n_states = std::max(1, n_states);
+        for (int i = 0; i < n_states; ++i) {
+            whisper_state *state = whisper_init_state(ctx_);
+            if (state == nullptr) {
+                std::cerr << "Error: failed to allocate whisper_state " << (i + 1) << " of " << n_states << std::endl;
+                break;
+            }
+            states_.push_back(state);
+        }
+        free_ = states_;
+        stats_.size = states_.size();
+
+        // Split the cores between the states so parallel decodes don't oversubscribe.
+        const int hw = std::max(1, (int) std::thread::hardware_concurrency());
+        n_threads_ = std::max(1, std::min(8, hw / std::max<int>(1, (int) states_.size())));
+
+        std::cout << "Whisper initialized with model: " << model_path << " (" << states_.size()
+                << " state(s), " << n_threads_ << " thread(s) each)" << std::endl;
     }
 
     ~WhisperImpl() {
+        for (whisper_state *state: states_) {
+            whisper_free_state(state);
+        }
+        states_.clear();
+        free_.clear();
         if (ctx_) {
             whisper_free(ctx_);
             ctx_ = nullptr;
         }
     }
 
-    std::string process_audio(const std::vector<float> &audio_data) {
-        if (!ctx_ || audio_data.empty()) {
-            return "";
+    whisper_state *acquire() {
+        std::unique_lock<std::mutex> lock(pool_mtx_);
+        if (free_.empty()) {
+            const auto start = std::chrono::steady_clock::now();
+            stats_.waits++;
+            pool_cv_.wait(lock, [this] { return !free_.empty(); });
+            stats_.wait_ms += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        whisper_state *state = free_.back();
+        free_.pop_back();
+        stats_.leases++;
+        stats_.in_use = states_.size() - free_.size();
+        return state;
+    }
+
+    void release(whisper_state *state) {
+        {
+            std::lock_guard<std::mutex> lock(pool_mtx_);
+            free_.push_back(state);
+            stats_.in_use = states_.size() - free_.size();
         }
+        pool_cv_.notify_one();
+    }
 
+    Whisper::PoolStats pool_stats() const {
+        std::lock_guard<std::mutex> lock(pool_mtx_);
+        return stats_;
+    }
+
+    whisper_full_params default_params() const {
         whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        params.n_threads = std::min(8, (int) std::thread::hardware_concurrency());
+        params.n_threads = n_threads_;
         params.print_progress = false;
         params.print_special = false;
         params.print_timestamps = false;
         params.print_realtime = false;
         params.suppress_blank = true;
         params.language = "en";
+        return params;
+    }
 
-        if (whisper_full(ctx_, params, audio_data.data(), audio_data.size()) != 0) {
-            std::cerr << "Error: failed to process audio with whisper_full" << std::endl;
+    std::string process_audio(whisper_state *state, const std::vector<float> &audio_data) {
+        if (!ctx_ || audio_data.empty()) {
             return "";
         }
 
         std::string result_text;
-        const int n_segments = whisper_full_n_segments(ctx_);
-        for (int i = 0; i < n_segments; ++i) {
-            const char *text = whisper_full_get_segment_text(ctx_, i);
-            result_text += text;
+        for (const auto &segment: transcribe(state, audio_data.data(), audio_data.size())) {
+            result_text += segment.text;
         }
 
         if (!result_text.empty()) {
@@ -71,18 +132,49 @@ public:
         return result_text;
     }
 
+    whisper_state *create_state() {
+        return ctx_ ? whisper_init_state(ctx_) : nullptr;
+    }
+
+    std::vector<Whisper::Segment> transcribe(whisper_state *state, const float *samples, size_t n_samples) {
+        std::vector<Whisper::Segment> segments;
+        if (!ctx_ || !state || n_samples == 0) {
+            return segments;
+        }
+
+        whisper_full_params params = default_params();
+        params.no_context = true; // Each window is decoded independently
+
+        if (whisper_full_with_state(ctx_, state, params, samples, static_cast<int>(n_samples)) != 0) {
+            std::cerr << "Error: failed to process audio with whisper_full_with_state" << std::endl;
+            return segments;
+        }
+
+        const int n_segments = whisper_full_n_segments_from_state(state);
+        segments.reserve(n_segments);
+        for (int i = 0; i < n_segments; ++i) {
+            Whisper::Segment segment;
+            segment.text = whisper_full_get_segment_text_from_state(state, i);
+            // whisper.cpp timestamps are in units of 10 ms.
+            segment.t0_ms = whisper_full_get_segment_t0_from_state(state, i) * 10;
+            segment.t1_ms = whisper_full_get_segment_t1_from_state(state, i) * 10;
+            segments.push_back(std::move(segment));
+        }
+        return segments;
+    }
+
     [[nodiscard]] bool is_model_loaded() const {
-        return ctx_ != nullptr;
+        return ctx_ != nullptr && !states_.empty();
     }
 };
 
 // --- Public Wrapper Function Implementations ---
 
 // UPDATED: Returns a unique_ptr and manages memory correctly.
-std::unique_ptr<Whisper> Whisper::create(const std::string &model_path) {
+std::unique_ptr<Whisper> Whisper::create(const std::string &model_path, int n_states) {
     // Use `new` because constructor is private. Wrap immediately in unique_ptr.
     auto instance = std::unique_ptr<Whisper>(new Whisper());
-    instance->impl_ = new WhisperImpl(model_path);
+    instance->impl_ = new WhisperImpl(model_path, n_states);
 
     if (instance->impl_->is_model_loaded()) {
         return instance; // Move the unique_ptr out.
@@ -94,7 +186,47 @@ std::unique_ptr<Whisper> Whisper::create(const std::string &model_path) {
 }
 
 std::string Whisper::process_audio(const std::vector<float> &audio_data) {
-    return impl_ ? impl_->process_audio(audio_data) : "";
+    if (!impl_ || audio_data.empty()) {
+        return "";
+    }
+    StateLease lease = lease_state();
+    return impl_->process_audio(lease.get(), audio_data);
+}
+
+Whisper::StateLease Whisper::lease_state() {
+    return StateLease(impl_, impl_->acquire());
+}
+
+Whisper::PoolStats Whisper::pool_stats() const {
+    return impl_ ? impl_->pool_stats() : PoolStats{};
+}
+
+Whisper::StateLease::StateLease(WhisperImpl *owner, whisper_state *state) : owner_(owner), state_(state) {
+}
+
+Whisper::StateLease::StateLease(StateLease &&other) noexcept : owner_(other.owner_), state_(other.state_) {
+    other.owner_ = nullptr;
+    other.state_ = nullptr;
+}
+
+Whisper::StateLease::~StateLease() {
+    if (owner_ && state_) {
+        owner_->release(state_);
+    }
+}
+
+Whisper::StatePtr Whisper::create_state() {
+    return StatePtr(impl_ ? impl_->create_state() : nullptr);
+}
+
+std::vector<Whisper::Segment> Whisper::transcribe(whisper_state *state, const float *samples, size_t n_samples) {
+    return impl_ ? impl_->transcribe(state, samples, n_samples) : std::vector<Segment>{};
+}
+
+void Whisper::StateDeleter::operator()(whisper_state *state) const {
+    if (state) {
+        whisper_free_state(state);
+    }
 }
 
 // REMOVED: destroy() method is gone.
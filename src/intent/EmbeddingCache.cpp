@@ -0,0 +1,182 @@
+#include "loki/intent/EmbeddingCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace loki {
+    namespace intent {
+        namespace {
+            constexpr char CACHE_MAGIC[8] = {'L', 'O', 'K', 'I', 'E', 'M', 'B', '1'};
+            constexpr uint32_t CACHE_VERSION = 1;
+
+            struct CacheHeader {
+                char magic[8];
+                uint32_t version;
+                uint32_t dim;
+                uint64_t model_hash;
+                uint64_t count;
+            };
+
+            static_assert(sizeof(CacheHeader) == 32, "cache header must stay 8-byte aligned");
+        } // namespace
+
+        // Read-only mapping of a whole file; empty if the file can't be mapped.
+        class EmbeddingCache::MappedFile {
+        public:
+            explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+                file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, NULL);
+                if (file_ == INVALID_HANDLE_VALUE) return;
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+                mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (!mapping_) return;
+                data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+                if (data_) size_ = static_cast<size_t>(size.QuadPart);
+#else
+                fd_ = ::open(path.c_str(), O_RDONLY);
+                if (fd_ < 0) return;
+                struct stat st;
+                if (fstat(fd_, &st) != 0 || st.st_size == 0) return;
+                void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+                if (data == MAP_FAILED) return;
+                data_ = data;
+                size_ = static_cast<size_t>(st.st_size);
+#endif
+            }
+
+            ~MappedFile() {
+#ifdef _WIN32
+                if (data_) UnmapViewOfFile(data_);
+                if (mapping_) CloseHandle(mapping_);
+                if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+                if (data_) munmap(data_, size_);
+                if (fd_ >= 0) ::close(fd_);
+#endif
+            }
+
+            const unsigned char *data() const { return static_cast<const unsigned char *>(data_); }
+            size_t size() const { return size_; }
+
+        private:
+            void *data_ = nullptr;
+            size_t size_ = 0;
+#ifdef _WIN32
+            HANDLE file_ = INVALID_HANDLE_VALUE;
+            HANDLE mapping_ = NULL;
+#else
+            int fd_ = -1;
+#endif
+        };
+
+        EmbeddingCache::~EmbeddingCache() = default;
+
+        std::unique_ptr<EmbeddingCache> EmbeddingCache::open(const std::string &path, uint64_t model_hash) {
+            std::unique_ptr<EmbeddingCache> cache(new EmbeddingCache());
+            if (!std::filesystem::exists(path)) {
+                return cache;
+            }
+
+            auto file = std::make_unique<MappedFile>(path);
+            if (file->size() < sizeof(CacheHeader)) {
+                std::cerr << "WARNING: Ignoring unreadable embedding cache '" << path << "'" << std::endl;
+                return cache;
+            }
+
+            CacheHeader header;
+            std::memcpy(&header, file->data(), sizeof(header));
+            if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION) {
+                std::cerr << "WARNING: Ignoring embedding cache '" << path << "' with an unknown format." << std::endl;
+                return cache;
+            }
+            if (header.model_hash != model_hash) {
+                std::cout << "Embedding model changed since '" << path << "' was written; rebuilding it." << std::endl;
+                return cache;
+            }
+            const size_t expected = sizeof(CacheHeader) + header.count * sizeof(uint64_t) +
+                                    header.count * header.dim * sizeof(float);
+            if (header.dim == 0 || file->size() != expected) {
+                std::cerr << "WARNING: Ignoring truncated embedding cache '" << path << "'" << std::endl;
+                return cache;
+            }
+
+            cache->keys_ = reinterpret_cast<const uint64_t *>(file->data() + sizeof(CacheHeader));
+            cache->vectors_ = reinterpret_cast<const float *>(cache->keys_ + header.count);
+            cache->count_ = static_cast<size_t>(header.count);
+            cache->dim_ = header.dim;
+            cache->file_ = std::move(file);
+            return cache;
+        }
+
+        const float *EmbeddingCache::find(uint64_t key) const {
+            const uint64_t *end = keys_ + count_;
+            const uint64_t *it = std::lower_bound(keys_, end, key);
+            if (it == end || *it != key) return nullptr;
+            return vectors_ + static_cast<size_t>(it - keys_) * dim_;
+        }
+
+        bool EmbeddingCache::write(const std::string &path, uint64_t model_hash, size_t dim,
+                                   std::vector<Entry> entries) {
+            std::sort(entries.begin(), entries.end(),
+                      [](const Entry &a, const Entry &b) { return a.key < b.key; });
+            entries.erase(std::unique(entries.begin(), entries.end(),
+                                      [](const Entry &a, const Entry &b) { return a.key == b.key; }),
+                          entries.end());
+
+            CacheHeader header{};
+            std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+            header.version = CACHE_VERSION;
+            header.dim = static_cast<uint32_t>(dim);
+            header.model_hash = model_hash;
+            header.count = entries.size();
+
+            // Write beside the target and rename, so a crash never leaves a torn cache.
+            const std::string tmp_path = path + ".tmp";
+            {
+                std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+                if (!out.is_open()) {
+                    std::cerr << "WARNING: Could not write embedding cache '" << tmp_path << "'" << std::endl;
+                    return false;
+                }
+                out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+                for (const auto &entry: entries) {
+                    out.write(reinterpret_cast<const char *>(&entry.key), sizeof(entry.key));
+                }
+                for (const auto &entry: entries) {
+                    out.write(reinterpret_cast<const char *>(entry.embedding),
+                              static_cast<std::streamsize>(dim * sizeof(float)));
+                }
+                if (!out.good()) {
+                    std::cerr << "WARNING: Failed while writing embedding cache '" << tmp_path << "'" << std::endl;
+                    out.close();
+                    std::remove(tmp_path.c_str());
+                    return false;
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tmp_path, path, ec);
+            if (ec) {
+                std::cerr << "WARNING: Could not replace embedding cache '" << path << "': " << ec.message()
+                        << std::endl;
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+            return true;
+        }
+    } // namespace intent
+} // namespace loki
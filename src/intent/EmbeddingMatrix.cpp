@@ -0,0 +1,165 @@
+#include "loki/intent/EmbeddingMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+// LOKI_HAVE_AVX2_KERNEL means EmbeddingMatrixAvx2.cpp is linked in; whether it
+// runs is decided once per process from CPUID.
+#if defined(LOKI_HAVE_AVX2_KERNEL) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LOKI_DOT_NEON 1
+#endif
+
+namespace loki {
+    namespace intent {
+#if defined(LOKI_HAVE_AVX2_KERNEL)
+        namespace detail {
+            float dot_avx2(const float *a, const float *b, size_t n); // EmbeddingMatrixAvx2.cpp
+        } // namespace detail
+#endif
+
+        namespace {
+            float dot_scalar(const float *a, const float *b, size_t n) {
+                float sum = 0.0f;
+                for (size_t i = 0; i < n; ++i) {
+                    sum += a[i] * b[i];
+                }
+                return sum;
+            }
+
+#if defined(LOKI_DOT_NEON)
+            float dot_neon(const float *a, const float *b, size_t n) {
+                float32x4_t acc0 = vdupq_n_f32(0.0f);
+                float32x4_t acc1 = vdupq_n_f32(0.0f);
+                float32x4_t acc2 = vdupq_n_f32(0.0f);
+                float32x4_t acc3 = vdupq_n_f32(0.0f);
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+                    acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+                    acc2 = vfmaq_f32(acc2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+                    acc3 = vfmaq_f32(acc3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+                }
+                for (; i + 4 <= n; i += 4) {
+                    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+                }
+                const float32x4_t acc = vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3));
+                return vaddvq_f32(acc) + dot_scalar(a + i, b + i, n - i);
+            }
+#endif
+
+            using DotKernel = float (*)(const float *, const float *, size_t);
+
+            struct Kernel {
+                DotKernel dot;
+                const char *name;
+            };
+
+#if defined(LOKI_HAVE_AVX2_KERNEL)
+            // The kernel needs FMA as well as AVX2, and the OS must save the YMM
+            // registers; __builtin_cpu_supports checks the latter itself.
+            bool cpu_has_avx2_fma() {
+#if defined(_MSC_VER)
+                int info[4];
+                __cpuid(info, 0);
+                if (info[0] < 7) return false;
+                __cpuid(info, 1);
+                const bool fma = (info[2] & (1 << 12)) != 0;
+                const bool osxsave = (info[2] & (1 << 27)) != 0;
+                const bool avx = (info[2] & (1 << 28)) != 0;
+                if (!fma || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+                __cpuidex(info, 7, 0);
+                return (info[1] & (1 << 5)) != 0;
+#else
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+            }
+#endif
+
+            const Kernel &kernel() {
+                static const Kernel selected = [] {
+#if defined(LOKI_HAVE_AVX2_KERNEL)
+                    if (cpu_has_avx2_fma()) return Kernel{detail::dot_avx2, "avx2"};
+#elif defined(LOKI_DOT_NEON)
+                    return Kernel{dot_neon, "neon"};
+#endif
+                    return Kernel{dot_scalar, "scalar"};
+                }();
+                return selected;
+            }
+        } // namespace
+
+        float EmbeddingMatrix::dot(const float *a, const float *b, size_t n) {
+            return kernel().dot(a, b, n);
+        }
+
+        const char *EmbeddingMatrix::kernel_name() {
+            return kernel().name;
+        }
+
+        bool EmbeddingMatrix::normalize(std::vector<float> &v) {
+            if (v.empty()) return false;
+            const float norm = std::sqrt(dot(v.data(), v.data(), v.size()));
+            if (norm == 0.0f || !std::isfinite(norm)) return false;
+            const float inv = 1.0f / norm;
+            for (float &x: v) {
+                x *= inv;
+            }
+            return true;
+        }
+
+        bool EmbeddingMatrix::add_row(const std::vector<float> &embedding) {
+            return add_row(embedding.data(), embedding.size());
+        }
+
+        bool EmbeddingMatrix::add_row(const float *embedding, size_t n) {
+            if (n == 0 || (rows_ > 0 && n != dim_)) {
+                return false;
+            }
+            std::vector<float> normalized(embedding, embedding + n);
+            if (!normalize(normalized)) {
+                return false;
+            }
+            if (rows_ == 0) {
+                dim_ = n;
+                stride_ = (dim_ + ROW_PAD - 1) / ROW_PAD * ROW_PAD;
+            }
+            // Padding stays zero, so it never contributes to a dot product.
+            data_.resize((rows_ + 1) * stride_, 0.0f);
+            std::copy(normalized.begin(), normalized.end(), data_.begin() + rows_ * stride_);
+            rows_++;
+            return true;
+        }
+
+        void EmbeddingMatrix::clear() {
+            data_.clear();
+            rows_ = 0;
+            dim_ = 0;
+            stride_ = 0;
+        }
+
+        void EmbeddingMatrix::scores(const float *query, std::vector<float> &out) const {
+            out.resize(rows_);
+            const DotKernel dot_fn = kernel().dot;
+            for (size_t r = 0; r < rows_; ++r) {
+                out[r] = dot_fn(row(r), query, dim_);
+            }
+        }
+
+        EmbeddingMatrix::Match EmbeddingMatrix::best_match(const float *query) const {
+            Match best;
+            const DotKernel dot_fn = kernel().dot;
+            for (size_t r = 0; r < rows_; ++r) {
+                const float score = dot_fn(row(r), query, dim_);
+                if (!best.found || score > best.score) {
+                    best.index = r;
+                    best.score = score;
+                    best.found = true;
+                }
+            }
+            return best;
+        }
+    } // namespace intent
+} // namespace loki
@@ -0,0 +1,37 @@
+// The only file built with AVX2/FMA enabled. EmbeddingMatrix.cpp calls into it
+// after checking the CPU, so the rest of the library stays baseline x86-64.
+#include <immintrin.h>
+#include <cstddef>
+
+namespace loki {
+    namespace intent {
+        namespace detail {
+            float dot_avx2(const float *a, const float *b, size_t n) {
+                // Four independent accumulators hide the FMA latency.
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                __m256 acc2 = _mm256_setzero_ps();
+                __m256 acc3 = _mm256_setzero_ps();
+                size_t i = 0;
+                for (; i + 32 <= n; i += 32) {
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+                    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+                    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+                }
+                for (; i + 8 <= n; i += 8) {
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+                }
+                __m256 acc = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+                __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+                sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+                float total = _mm_cvtss_f32(sum);
+                for (; i < n; ++i) {
+                    total += a[i] * b[i];
+                }
+                return total;
+            }
+        } // namespace detail
+    } // namespace intent
+} // namespace loki
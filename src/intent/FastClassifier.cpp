@@ -1,26 +1,22 @@
 #include "loki/intent/FastClassifier.h"
+#include "loki/core/Hash.h"
+#include "loki/intent/EmbeddingCache.h"
 #include <iostream>
-#include <numeric>
 #include <cmath>
 #include <string>
 #include <cctype>
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <stdexcept>
+#include <unordered_set>
 
-// Helper function to calculate cosine similarity between two vectors
-float cosine_similarity(const std::vector<float> &a, const std::vector<float> &b) {
-    if (a.size() != b.size() || a.empty()) {
-        return 0.0f;
-    }
-    float dot_product = std::inner_product(a.begin(), a.end(), b.begin(), 0.0f);
-    float norm_a = std::sqrt(std::inner_product(a.begin(), a.end(), a.begin(), 0.0f));
-    float norm_b = std::sqrt(std::inner_product(b.begin(), b.end(), b.begin(), 0.0f));
-
-    if (norm_a == 0.0f || norm_b == 0.0f) {
-        return 0.0f;
-    }
-    return dot_product / (norm_a * norm_b);
-}
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 namespace loki {
     namespace intent {
@@ -35,89 +31,603 @@ namespace loki {
             return output;
         }
 
+        // Filler words that don't change what a command means. Used only for the
+        // stopword-stripped lexical lookup, never for embeddings.
+        static const std::unordered_set<std::string> &lexical_stopwords() {
+            static const std::unordered_set<std::string> words = {
+                "a", "an", "the", "please", "can", "could", "would", "will", "you", "hey", "loki", "just",
+                "kindly", "me", "my", "for", "now"
+            };
+            return words;
+        }
+
+        // Collapses whitespace in already-normalized text, optionally dropping stopwords.
+        static std::string lexical_key(const std::string &normalized, bool strip_stopwords) {
+            std::string key;
+            size_t pos = 0;
+            while (pos < normalized.size()) {
+                while (pos < normalized.size() && std::isspace(static_cast<unsigned char>(normalized[pos]))) pos++;
+                size_t end = pos;
+                while (end < normalized.size() && !std::isspace(static_cast<unsigned char>(normalized[end]))) end++;
+                if (end > pos) {
+                    std::string word = normalized.substr(pos, end - pos);
+                    if (!strip_stopwords || lexical_stopwords().count(word) == 0) {
+                        if (!key.empty()) key += ' ';
+                        key += word;
+                    }
+                }
+                pos = end;
+            }
+            return key;
+        }
+
+        FastClassifier::Options FastClassifier::Options::from_config(const loki::core::Config &config) {
+            Options options;
+            options.use_hnsw = config.get("INTENT_INDEX", "exact") == "hnsw";
+            options.hnsw_min_prompts = std::stoul(config.get("INTENT_HNSW_MIN_PROMPTS", "2000"));
+            options.hnsw.M = std::stoul(config.get("INTENT_HNSW_M", "16"));
+            options.hnsw.ef_construction = std::stoul(config.get("INTENT_HNSW_EF_CONSTRUCTION", "100"));
+            options.hnsw.ef_search = std::stoul(config.get("INTENT_HNSW_EF_SEARCH", "64"));
+            options.transcript_cache_capacity = std::stoul(config.get("INTENT_TRANSCRIPT_CACHE_SIZE", "256"));
+            options.lexical_match = config.get("INTENT_LEXICAL_MATCH", "1") == "1";
+            options.lexical_strip_stopwords = config.get("INTENT_LEXICAL_STOPWORDS", "1") == "1";
+            options.watch_intents_file = config.get("INTENT_HOT_RELOAD", "1") == "1";
+            options.embedding_cache_path = config.get_path("INTENT_EMBEDDING_CACHE", "intent_embeddings.cache");
+            options.online_learning = config.get("INTENT_LEARN", "0") == "1";
+            options.learned_prompts_path = config.get_path("INTENT_LEARN_PATH", "learned_intents.jsonl");
+            options.learned_per_intent_cap = std::stoul(config.get("INTENT_LEARN_MAX_PER_INTENT", "50"));
+            options.learn_min_confidence = config.get_float("INTENT_LEARN_MIN_CONFIDENCE", 0.9f);
+            return options;
+        }
+
         FastClassifier::FastClassifier(const std::string &intents_path, EmbeddingModel &embedding_model)
-            : embedding_model_(embedding_model) {
+            : FastClassifier(intents_path, embedding_model, Options()) {
+        }
+
+        FastClassifier::FastClassifier(const std::string &intents_path, EmbeddingModel &embedding_model,
+                                       const Options &classifier_options)
+            : intents_path_(intents_path),
+              options_(classifier_options),
+              embedding_model_(embedding_model),
+              transcript_embeddings_(classifier_options.transcript_cache_capacity) {
             std::cout << "Loading intents from '" << intents_path << "'..." << std::endl;
-            std::ifstream intents_file(intents_path);
+            std::shared_ptr<const Catalog> catalog = load_catalog(nullptr);
+
+            if (catalog->ann_index) {
+                std::cout << "Built HNSW index (M=" << catalog->ann_index->options().M << ", ef_search="
+                        << catalog->ann_index->options().ef_search << ", " << catalog->ann_index->max_level() + 1
+                        << " layers)." << std::endl;
+            }
+            if (options_.lexical_match) {
+                std::cout << "Lexical index: " << catalog->exact_prompts.size() << " exact and "
+                        << catalog->stripped_prompts.size() << " stopword-stripped prompt keys." << std::endl;
+            }
+            std::cout << "FastClassifier is ready with " << catalog->known_intents.size() << " training prompts ("
+                    << EmbeddingMatrix::kernel_name() << " similarity kernel, "
+                    << (catalog->ann_index ? "HNSW" : "exact") << " search)." << std::endl;
+            std::atomic_store(&catalog_, std::move(catalog));
+
+            if (options_.watch_intents_file) {
+                watcher_ = std::thread(&FastClassifier::watch_intents_file, this);
+            }
+        }
+
+        FastClassifier::~FastClassifier() {
+            {
+                std::lock_guard<std::mutex> lock(watcher_mtx_);
+                stop_watching_ = true;
+            }
+            watcher_cv_.notify_all();
+            if (watcher_.joinable()) {
+                watcher_.join();
+            }
+        }
+
+        std::shared_ptr<const FastClassifier::Catalog> FastClassifier::load_catalog(const Catalog *previous) const {
+            std::ifstream intents_file(intents_path_);
             if (!intents_file.is_open()) {
-                throw std::runtime_error("Failed to open intents file: " + intents_path);
+                throw std::runtime_error("Failed to open intents file: " + intents_path_);
             }
 
             nlohmann::json intents_json = nlohmann::json::parse(intents_file);
+            auto catalog = std::make_shared<Catalog>();
 
-            std::cout << "Pre-computing embeddings for known intents..." << std::endl;
+            if (!previous) {
+                std::cout << "Pre-computing embeddings for known intents..." << std::endl;
+            }
+
+            // Prompts already in the on-disk cache (same model, same normalized
+            // text) are copied straight from the mapped file instead of encoded.
+            const bool use_cache = !options_.embedding_cache_path.empty();
+            const uint64_t model_hash = use_cache ? embedding_model_.model_hash() : 0;
+            std::unique_ptr<EmbeddingCache> cache;
+            if (model_hash != 0) {
+                cache = EmbeddingCache::open(options_.embedding_cache_path, model_hash);
+            }
+
+            // On a reload, unchanged prompts keep the row they already had.
+            std::unordered_map<uint64_t, size_t> previous_rows;
+            if (previous) {
+                for (size_t i = 0; i < previous->prompt_keys.size(); ++i) {
+                    previous_rows.emplace(previous->prompt_keys[i], i);
+                }
+            }
+
+            struct PendingPrompt {
+                KnownIntent intent;
+                std::string normalized;
+                uint64_t key;
+                const float *cached;
+                size_t cached_dim;
+            };
+            std::vector<PendingPrompt> pending;
+            std::vector<std::string> to_embed;
+            size_t reused = 0;
+            auto add_pending = [&](KnownIntent intent) {
+                PendingPrompt p;
+                p.intent = std::move(intent);
+                p.normalized = normalize_text(p.intent.text_prompt);
+                p.key = loki::core::fnv1a_64(p.normalized);
+                auto previous_row = previous_rows.find(p.key);
+                if (previous_row != previous_rows.end()) {
+                    p.cached = previous->intent_matrix.row(previous_row->second);
+                    p.cached_dim = previous->intent_matrix.dim();
+                    reused++;
+                } else {
+                    p.cached = cache ? cache->find(p.key) : nullptr;
+                    p.cached_dim = cache ? cache->dim() : 0;
+                }
+                if (!p.cached) {
+                    to_embed.push_back(p.normalized);
+                }
+                pending.push_back(std::move(p));
+            };
 
             // This loop replaces the hardcoded vector entirely.
             for (const auto &intent_group: intents_json) {
                 std::string type = intent_group.at("type");
                 std::string action = intent_group.at("action");
 
+                // "slots": {"name": {"chrome": ["chrome", "browser"]}, "level": "percent"}
+                // Each slot is either a map of value -> phrases, or "number" / "percent".
+                if (intent_group.contains("slots")) {
+                    for (const auto &slot: intent_group.at("slots").items()) {
+                        if (slot.value().is_string()) {
+                            const std::string kind = slot.value().get<std::string>();
+                            if (kind != "number" && kind != "percent") {
+                                throw std::runtime_error("Unknown slot type '" + kind + "' for " + action + "." +
+                                                         slot.key());
+                            }
+                            catalog->slot_extractor.add_numeric_slot(action, slot.key(), kind == "percent"
+                                                                         ? SlotExtractor::NumericKind::Percent
+                                                                         : SlotExtractor::NumericKind::Number);
+                            continue;
+                        }
+                        for (const auto &value: slot.value().items()) {
+                            for (const auto &phrase: value.value()) {
+                                catalog->slot_extractor.add_phrase(action, slot.key(),
+                                                                   normalize_text(phrase.get<std::string>()),
+                                                                   value.key());
+                            }
+                        }
+                    }
+                }
+
                 for (const auto &prompt: intent_group.at("prompts")) {
-                    std::string prompt_str = prompt.get<std::string>();
-                    std::string normalized_prompt = normalize_text(prompt_str);
+                    add_pending({prompt.get<std::string>(), type, action});
+                }
+            }
+
+            // Learned prompts go last, so one that later made it into the intents
+            // file is only counted once.
+            std::unordered_set<uint64_t> seen;
+            for (const auto &p: pending) seen.insert(p.key);
+            for (auto &intent: read_learned_prompts(seen)) {
+                catalog->learned_counts[intent.type + "/" + intent.action]++;
+                add_pending(std::move(intent));
+            }
 
-                    KnownIntent known_intent;
-                    known_intent.text_prompt = prompt_str;
-                    known_intent.type = type;
-                    known_intent.action = action;
-                    known_intent.embedding = embedding_model_.get_embeddings(normalized_prompt);
+            catalog->slot_extractor.compile();
 
-                    known_intents_.push_back(std::move(known_intent));
+            // Everything the cache didn't have is encoded in one batched pass. It
+            // runs on its own context, so a reload never holds up classify().
+            const auto embedded = embedding_model_.get_embeddings_batch(to_embed);
+
+            auto &known_intents = catalog->known_intents;
+            auto &intent_matrix = catalog->intent_matrix;
+            size_t cache_hits = 0;
+            size_t next_embedded = 0;
+            for (auto &p: pending) {
+                // Normalized once here so classify() only needs dot products.
+                const bool added = p.cached
+                                       ? intent_matrix.add_row(p.cached, p.cached_dim)
+                                       : intent_matrix.add_row(embedded[next_embedded++]);
+                if (!added) {
+                    std::cerr << "WARNING: Skipping prompt with no usable embedding: '" << p.intent.text_prompt << "'"
+                            << std::endl;
+                    continue;
+                }
+                // The exact index is built even without lexical matching: learn()
+                // checks it for prompts the catalog already has.
+                catalog->add_lexical_prompt(catalog->exact_prompts, lexical_key(p.normalized, false),
+                                            known_intents.size(), p.intent);
+                if (options_.lexical_match && options_.lexical_strip_stopwords) {
+                    catalog->add_lexical_prompt(catalog->stripped_prompts, lexical_key(p.normalized, true),
+                                                known_intents.size(), p.intent);
                 }
+                known_intents.push_back(std::move(p.intent));
+                catalog->prompt_keys.push_back(p.key);
+                cache_hits += p.cached != nullptr;
             }
 
-            std::cout << "FastClassifier is ready with " << known_intents_.size() << " training prompts." << std::endl;
+            if (model_hash != 0) {
+                // Rewrite the cache if anything was encoded or prompts were removed.
+                const size_t cached_entries = cache->size();
+                cache.reset(); // Unmap before the file is replaced
+                const auto &prompt_keys = catalog->prompt_keys;
+                const std::unordered_set<uint64_t> unique_keys(prompt_keys.begin(), prompt_keys.end());
+                // A catalog with no usable prompts has no dimension, and a cache
+                // written with dim 0 would only be rejected on the next launch.
+                if (intent_matrix.dim() > 0 &&
+                    (cache_hits < known_intents.size() || cached_entries != unique_keys.size())) {
+                    std::vector<EmbeddingCache::Entry> entries;
+                    entries.reserve(prompt_keys.size());
+                    for (size_t i = 0; i < prompt_keys.size(); ++i) {
+                        entries.push_back({prompt_keys[i], intent_matrix.row(i)});
+                    }
+                    EmbeddingCache::write(options_.embedding_cache_path, model_hash, intent_matrix.dim(),
+                                          std::move(entries));
+                }
+                if (!previous) {
+                    std::cout << "Embedding cache: " << cache_hits << " of " << known_intents.size()
+                            << " prompts loaded from '" << options_.embedding_cache_path << "'." << std::endl;
+                }
+            }
+            if (previous) {
+                std::cout << "Intents reloaded: " << known_intents.size() << " prompts, " << reused
+                        << " unchanged, " << to_embed.size() << " re-encoded." << std::endl;
+            }
+
+            if (options_.use_hnsw && known_intents.size() >= options_.hnsw_min_prompts) {
+                catalog->ann_index = std::make_unique<HnswIndex>(intent_matrix, options_.hnsw);
+            }
+            return catalog;
         }
 
-        FastClassifier::ClassificationResult FastClassifier::classify(const std::string &transcript) const {
-            ClassificationResult result;
-            if (transcript.empty()) return result;
+        std::vector<KnownIntent> FastClassifier::read_learned_prompts(const std::unordered_set<uint64_t> &seen) const {
+            std::vector<KnownIntent> learned;
+            if (options_.learned_prompts_path.empty()) return learned;
+            std::ifstream in(options_.learned_prompts_path);
+            if (!in.is_open()) return learned; // Nothing learned yet
 
-            std::string normalized_transcript = normalize_text(transcript);
-            std::vector<float> transcript_embedding = embedding_model_.get_embeddings(normalized_transcript);
+            std::unordered_set<uint64_t> keys = seen;
+            std::unordered_map<std::string, size_t> counts;
+            std::string line;
+            size_t skipped = 0;
+            while (std::getline(in, line)) {
+                const nlohmann::json entry = nlohmann::json::parse(line, nullptr, false);
+                if (entry.is_discarded() || !entry.is_object() || !entry.contains("text")) {
+                    skipped += !line.empty();
+                    continue;
+                }
+                KnownIntent intent{entry.value("text", ""), entry.value("type", ""), entry.value("action", "")};
+                if (intent.type.empty() || intent.action.empty()) {
+                    skipped++;
+                    continue;
+                }
+                if (!keys.insert(loki::core::fnv1a_64(normalize_text(intent.text_prompt))).second) continue;
+                if (++counts[intent.type + "/" + intent.action] > options_.learned_per_intent_cap) continue;
+                learned.push_back(std::move(intent));
+            }
+            if (skipped > 0) {
+                std::cerr << "WARNING: Skipped " << skipped << " malformed lines in '" << options_.learned_prompts_path
+                        << "'" << std::endl;
+            }
+            return learned;
+        }
 
-            float best_score = 0.0f;
-            const KnownIntent *best_match = nullptr;
+        bool FastClassifier::learn(const std::string &transcript, const loki::intent::Intent &intent) {
+            if (!options_.online_learning) return false;
+            const std::string normalized = normalize_text(transcript);
+            if (intent.type == "unknown" || intent.action.empty() || intent.confidence < options_.learn_min_confidence
+                || lexical_key(normalized, false).empty()) {
+                learn_rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
 
-            for (const auto &known_intent: known_intents_) {
-                float score = cosine_similarity(transcript_embedding, known_intent.embedding);
-                if (score > best_score) {
-                    best_score = score;
-                    best_match = &known_intent;
+            std::lock_guard<std::mutex> lock(reload_mtx_);
+            const std::shared_ptr<const Catalog> current = std::atomic_load(&catalog_);
+            const uint64_t key = loki::core::fnv1a_64(normalized);
+            const std::string exact_key = lexical_key(normalized, false);
+            if (current->exact_prompts.count(exact_key) != 0) {
+                learn_duplicates_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            const std::string intent_key = intent.type + "/" + intent.action;
+            auto count = current->learned_counts.find(intent_key);
+            if (count != current->learned_counts.end() && count->second >= options_.learned_per_intent_cap) {
+                learn_capped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // A fast-path hit on this prompt gets its parameters from the slot
+            // extractor, so it has to find what the LLM found.
+            const nlohmann::json parameters = current->slot_extractor.extract(intent.action, normalized);
+            for (const auto &item: intent.parameters.items()) {
+                if (!parameters.contains(item.key()) || parameters.at(item.key()) != item.value()) {
+                    learn_rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
                 }
             }
+            std::vector<float> embedding;
+            if (!embed(*current, normalized, embedding)) {
+                learn_rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Catalogs are immutable, so the learned prompt goes into a copy. The
+            // HNSW graph is copied and extended by one node rather than rebuilt.
+            auto next = std::make_shared<Catalog>();
+            next->known_intents = current->known_intents;
+            next->prompt_keys = current->prompt_keys;
+            next->intent_matrix = current->intent_matrix;
+            next->slot_extractor = current->slot_extractor;
+            next->exact_prompts = current->exact_prompts;
+            next->stripped_prompts = current->stripped_prompts;
+            next->learned_counts = current->learned_counts;
+            // The row goes in first: a prompt the matrix rejects must not reach the
+            // lexical indexes or the learned prompts file either.
+            if (!next->intent_matrix.add_row(embedding)) {
+                learn_rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            KnownIntent learned{transcript, intent.type, intent.action};
+            if (!options_.learned_prompts_path.empty()) {
+                std::ofstream out(options_.learned_prompts_path, std::ios::app);
+                if (out.is_open()) {
+                    out << nlohmann::json{{"text", learned.text_prompt}, {"type", learned.type}, {"action", learned.action}}
+                            .dump() << '\n';
+                } else {
+                    std::cerr << "WARNING: Could not append to '" << options_.learned_prompts_path
+                            << "'; the prompt is only learned until restart." << std::endl;
+                }
+            }
+
+            next->add_lexical_prompt(next->exact_prompts, exact_key, next->known_intents.size(), learned);
+            if (options_.lexical_match && options_.lexical_strip_stopwords) {
+                next->add_lexical_prompt(next->stripped_prompts, lexical_key(normalized, true),
+                                         next->known_intents.size(), learned);
+            }
+            next->known_intents.push_back(std::move(learned));
+            next->prompt_keys.push_back(key);
+            next->learned_counts[intent_key]++;
+            if (current->ann_index) {
+                next->ann_index = std::make_unique<HnswIndex>(*current->ann_index, next->intent_matrix);
+                next->ann_index->extend();
+            } else if (options_.use_hnsw && next->known_intents.size() >= options_.hnsw_min_prompts) {
+                next->ann_index = std::make_unique<HnswIndex>(next->intent_matrix, options_.hnsw);
+            }
+            std::atomic_store(&catalog_, std::shared_ptr<const Catalog>(std::move(next)));
+            learned_.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "Learned prompt '" << transcript << "' for " << intent_key << "." << std::endl;
+            return true;
+        }
+
+        FastClassifier::LearningStats FastClassifier::learning_stats() const {
+            LearningStats stats;
+            stats.learned = learned_.load(std::memory_order_relaxed);
+            stats.duplicates = learn_duplicates_.load(std::memory_order_relaxed);
+            stats.capped = learn_capped_.load(std::memory_order_relaxed);
+            stats.rejected = learn_rejected_.load(std::memory_order_relaxed);
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            for (const auto &entry: catalog->learned_counts) stats.learned_prompts += entry.second;
+            return stats;
+        }
+
+        bool FastClassifier::reload() {
+            std::lock_guard<std::mutex> lock(reload_mtx_);
+            const auto start = std::chrono::steady_clock::now();
+            const std::shared_ptr<const Catalog> current = std::atomic_load(&catalog_);
+            std::shared_ptr<const Catalog> next;
+            try {
+                next = load_catalog(current.get());
+            } catch (const std::exception &e) {
+                std::cerr << "ERROR: Keeping the current intents; could not reload '" << intents_path_ << "': "
+                        << e.what() << std::endl;
+                return false;
+            }
+            // Calls still running on the old catalog keep it alive until they return.
+            std::atomic_store(&catalog_, std::move(next));
+            reloads_.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "Swapped in the new intent catalog after " << std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count() << " ms." << std::endl;
+            return true;
+        }
+
+        void FastClassifier::watch_intents_file() {
+            namespace fs = std::filesystem;
+            const fs::path file_path(intents_path_);
+            // Editors often save by writing a new file and renaming it over the
+            // old one, so watch the directory and filter by name.
+            const fs::path dir = file_path.has_parent_path() ? file_path.parent_path() : fs::path(".");
+            const std::string file_name = file_path.filename().string();
+            // Let a burst of writes from one save settle before reloading.
+            const auto settle = std::chrono::milliseconds(250);
+
+            auto stopping = [this](std::chrono::milliseconds wait) {
+                std::unique_lock<std::mutex> lock(watcher_mtx_);
+                return watcher_cv_.wait_for(lock, wait, [this] { return stop_watching_; });
+            };
+
+#ifdef __linux__
+            const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            const int wd = fd >= 0
+                               ? inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+                               : -1;
+            if (wd >= 0) {
+                std::cout << "Watching '" << intents_path_ << "' for changes (inotify)." << std::endl;
+                alignas(inotify_event) char buffer[4096];
+                while (true) {
+                    // poll() times out regularly so the destructor never waits long.
+                    pollfd pfd{fd, POLLIN, 0};
+                    const int ready = poll(&pfd, 1, static_cast<int>(settle.count()));
+                    if (stopping(std::chrono::milliseconds(0))) break;
+                    if (ready <= 0) continue;
+
+                    bool changed = false;
+                    ssize_t length;
+                    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                        for (char *ptr = buffer; ptr < buffer + length;) {
+                            const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                            if (event->len > 0 && file_name == event->name) changed = true;
+                            ptr += sizeof(inotify_event) + event->len;
+                        }
+                    }
+                    if (!changed) continue;
+                    if (stopping(settle)) break;
+                    while (read(fd, buffer, sizeof(buffer)) > 0) {
+                        // Drop the rest of the burst; one reload covers it.
+                    }
+                    reload();
+                }
+                close(fd);
+                return;
+            }
+            if (fd >= 0) close(fd);
+            std::cerr << "WARNING: inotify unavailable for '" << dir.string() << "'; polling for changes instead."
+                    << std::endl;
+#endif
+
+            // Portable fallback: compare the modification time once a second.
+            std::error_code ec;
+            auto last_write = fs::last_write_time(file_path, ec);
+            std::cout << "Watching '" << intents_path_ << "' for changes (polling)." << std::endl;
+            while (!stopping(std::chrono::seconds(1))) {
+                const auto write_time = fs::last_write_time(file_path, ec);
+                if (ec || write_time == last_write) continue;
+                last_write = write_time;
+                if (stopping(settle)) break;
+                reload();
+            }
+        }
+
+        FastClassifier::ClassificationResult FastClassifier::classify(const std::string &transcript) const {
+            if (transcript.empty()) return {};
+            // Pin the current catalog; a concurrent reload can't free it under us.
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            const std::string normalized_transcript = normalize_text(transcript);
+            ClassificationResult result = match_lexical(*catalog, normalized_transcript);
+            return result.has_match ? result : match_embedding(*catalog, normalized_transcript);
+        }
+
+        FastClassifier::ClassificationResult FastClassifier::classify_lexical(const std::string &transcript) const {
+            if (transcript.empty()) return {};
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            return match_lexical(*catalog, normalize_text(transcript));
+        }
+
+        FastClassifier::ClassificationResult FastClassifier::classify_embedding(const std::string &transcript) const {
+            if (transcript.empty()) return {};
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            return match_embedding(*catalog, normalize_text(transcript));
+        }
+
+        FastClassifier::ClassificationResult FastClassifier::match_lexical(
+            const Catalog &catalog, const std::string &normalized_transcript) const {
+            ClassificationResult result;
+            if (!options_.lexical_match) return result;
+
+            // A transcript that is word-for-word one of the prompts needs no embedding.
+            lexical_lookups_.fetch_add(1, std::memory_order_relaxed);
+            const KnownIntent *lexical = catalog.find_lexical(catalog.exact_prompts,
+                                                              lexical_key(normalized_transcript, false));
+            if (lexical) {
+                lexical_exact_hits_.fetch_add(1, std::memory_order_relaxed);
+            } else if (options_.lexical_strip_stopwords) {
+                lexical = catalog.find_lexical(catalog.stripped_prompts, lexical_key(normalized_transcript, true));
+                if (lexical) lexical_stripped_hits_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (lexical) {
+                result.has_match = true;
+                result.confidence = 1.0f;
+                result.type = lexical->type;
+                result.action = lexical->action;
+                result.parameters = catalog.slot_extractor.extract(result.action, normalized_transcript);
+            }
+            return result;
+        }
+
+        bool FastClassifier::embed(const Catalog &catalog, const std::string &normalized_transcript,
+                                   std::vector<float> &embedding) const {
+            if (transcript_embeddings_.get(normalized_transcript, embedding)) return true;
+            embedding = embedding_model_.get_embeddings(normalized_transcript);
+            if (embedding.size() != catalog.intent_matrix.dim() || !EmbeddingMatrix::normalize(embedding)) {
+                return false;
+            }
+            transcript_embeddings_.put(normalized_transcript, embedding);
+            return true;
+        }
+
+        FastClassifier::ClassificationResult FastClassifier::match_embedding(
+            const Catalog &catalog, const std::string &normalized_transcript) const {
+            ClassificationResult result;
+            std::vector<float> transcript_embedding;
+            if (!embed(catalog, normalized_transcript, transcript_embedding)) return result;
+
+            const auto match = catalog.ann_index
+                                   ? catalog.ann_index->best_match(transcript_embedding.data())
+                                   : catalog.intent_matrix.best_match(transcript_embedding.data());
+            const KnownIntent *best_match = match.found ? &catalog.known_intents[match.index] : nullptr;
+            const float best_score = match.score;
 
             if (best_match && best_score >= SIMILARITY_THRESHOLD) {
                 result.has_match = true;
                 result.confidence = best_score;
                 result.type = best_match->type;
                 result.action = best_match->action;
-                if (result.action == "launch_application") {
-                    if (normalized_transcript.find("chrome") != std::string::npos || normalized_transcript.find(
-                            "browser") !=
-                        std::string::npos) {
-                        result.parameters["name"] = "chrome";
-                    } else if (normalized_transcript.find("firefox") != std::string::npos) {
-                        result.parameters["name"] = "firefox";
-                    } else if (normalized_transcript.find("notepad") != std::string::npos) {
-                        result.parameters["name"] = "notepad";
-                    } // ... etc.
-                } else if (result.action == "set_volume") {
-                    if (normalized_transcript.find("up") != std::string::npos || normalized_transcript.find("increase")
-                        !=
-                        std::string::npos || normalized_transcript.find("louder") != std::string::npos) {
-                        result.parameters["direction"] = "up";
-                    } else if (normalized_transcript.find("down") != std::string::npos || normalized_transcript.find(
-                                   "decrease")
-                               != std::string::npos || normalized_transcript.find("quieter") != std::string::npos) {
-                        result.parameters["direction"] = "down";
-                    } else if (normalized_transcript.find("mute") != std::string::npos) {
-                        result.parameters["direction"] = "mute";
-                    }
-                }
+                result.parameters = catalog.slot_extractor.extract(result.action, normalized_transcript);
             }
 
             return result;
         }
+
+        bool FastClassifier::transcript_embedding(const std::string &transcript, std::vector<float> &embedding) const {
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            return embed(*catalog, normalize_text(transcript), embedding);
+        }
+
+        nlohmann::json FastClassifier::extract_parameters(const std::string &action,
+                                                          const std::string &transcript) const {
+            const std::shared_ptr<const Catalog> catalog = std::atomic_load(&catalog_);
+            return catalog->slot_extractor.extract(action, normalize_text(transcript));
+        }
+
+        const KnownIntent *FastClassifier::Catalog::find_lexical(const LexicalIndex &index,
+                                                                 const std::string &key) const {
+            if (key.empty()) return nullptr;
+            auto it = index.find(key);
+            if (it == index.end() || it->second == AMBIGUOUS_PROMPT) return nullptr;
+            return &known_intents[it->second];
+        }
+
+        void FastClassifier::Catalog::add_lexical_prompt(LexicalIndex &index, const std::string &key,
+                                                         size_t intent_index, const KnownIntent &intent) {
+            if (key.empty()) return;
+            auto inserted = index.emplace(key, intent_index);
+            if (inserted.second || inserted.first->second == AMBIGUOUS_PROMPT) return;
+            // The same words under two different intents can't be resolved without embeddings.
+            const KnownIntent &existing = known_intents[inserted.first->second];
+            if (existing.type != intent.type || existing.action != intent.action) {
+                inserted.first->second = AMBIGUOUS_PROMPT;
+            }
+        }
+
+        FastClassifier::LexicalStats FastClassifier::lexical_stats() const {
+            LexicalStats stats;
+            stats.lookups = lexical_lookups_.load(std::memory_order_relaxed);
+            stats.exact_hits = lexical_exact_hits_.load(std::memory_order_relaxed);
+            stats.stripped_hits = lexical_stripped_hits_.load(std::memory_order_relaxed);
+            return stats;
+        }
     } // namespace intent
 } // namespace loki
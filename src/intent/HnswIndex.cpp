@@ -0,0 +1,223 @@
+#include "loki/intent/HnswIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <random>
+
+namespace loki {
+    namespace intent {
+        namespace {
+            HnswOptions sanitize(HnswOptions options) {
+                options.M = std::max<size_t>(2, options.M);
+                options.ef_construction = std::max(options.ef_construction, options.M);
+                options.ef_search = std::max<size_t>(1, options.ef_search);
+                return options;
+            }
+
+            // Per-thread "visited" marks. Every search takes a fresh tag, so the
+            // array never has to be cleared between queries.
+            struct VisitedList {
+                std::vector<uint32_t> tags;
+                uint32_t current = 0;
+
+                uint32_t begin(size_t n) {
+                    if (tags.size() < n) tags.resize(n, 0);
+                    if (++current == 0) {
+                        std::fill(tags.begin(), tags.end(), 0);
+                        current = 1;
+                    }
+                    return current;
+                }
+            };
+
+            VisitedList &visited_list() {
+                thread_local VisitedList list;
+                return list;
+            }
+        } // namespace
+
+        HnswIndex::HnswIndex(const EmbeddingMatrix &matrix, const HnswOptions &options)
+            : matrix_(matrix), options_(sanitize(options)), rng_(options_.seed) {
+            extend();
+        }
+
+        HnswIndex::HnswIndex(const HnswIndex &other, const EmbeddingMatrix &matrix)
+            : matrix_(matrix), options_(other.options_), rng_(other.rng_), levels_(other.levels_),
+              links_(other.links_), entry_point_(other.entry_point_), max_level_(other.max_level_) {
+        }
+
+        void HnswIndex::extend() {
+            const size_t n = matrix_.rows();
+            if (n <= levels_.size()) return;
+            levels_.reserve(n);
+            links_.resize(n);
+
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            const double level_mult = 1.0 / std::log(static_cast<double>(options_.M));
+            for (auto id = static_cast<uint32_t>(levels_.size()); id < n; ++id) {
+                const double u = std::max(uniform(rng_), 1e-12);
+                const int level = static_cast<int>(-std::log(u) * level_mult);
+                levels_.push_back(level);
+                insert(id, level);
+            }
+        }
+
+        float HnswIndex::similarity(const float *query, uint32_t id) const {
+            return EmbeddingMatrix::dot(matrix_.row(id), query, matrix_.dim());
+        }
+
+        HnswIndex::Candidate HnswIndex::greedy_descend(const float *query, Candidate current, int level) const {
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (uint32_t neighbor: links_[current.id][level]) {
+                    const float score = similarity(query, neighbor);
+                    if (score > current.score) {
+                        current = {score, neighbor};
+                        changed = true;
+                    }
+                }
+            }
+            return current;
+        }
+
+        std::vector<HnswIndex::Candidate> HnswIndex::search_layer(const float *query,
+                                                                  const std::vector<Candidate> &entry, size_t ef,
+                                                                  int level) const {
+            auto worse = [](const Candidate &a, const Candidate &b) { return a.score < b.score; };
+            auto better = [](const Candidate &a, const Candidate &b) { return a.score > b.score; };
+            // `frontier` pops the most similar candidate; `results` keeps the best
+            // `ef` found so far with the least similar on top.
+            std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> frontier(worse);
+            std::priority_queue<Candidate, std::vector<Candidate>, decltype(better)> results(better);
+
+            VisitedList &visited = visited_list();
+            const uint32_t tag = visited.begin(levels_.size());
+            for (const auto &e: entry) {
+                if (visited.tags[e.id] == tag) continue;
+                visited.tags[e.id] = tag;
+                frontier.push(e);
+                results.push(e);
+                if (results.size() > ef) results.pop();
+            }
+
+            while (!frontier.empty()) {
+                const Candidate current = frontier.top();
+                if (results.size() >= ef && current.score < results.top().score) {
+                    break; // Nothing left in the frontier can improve the results
+                }
+                frontier.pop();
+
+                for (uint32_t neighbor: links_[current.id][level]) {
+                    if (visited.tags[neighbor] == tag) continue;
+                    visited.tags[neighbor] = tag;
+                    const float score = similarity(query, neighbor);
+                    if (results.size() < ef || score > results.top().score) {
+                        frontier.push({score, neighbor});
+                        results.push({score, neighbor});
+                        if (results.size() > ef) results.pop();
+                    }
+                }
+            }
+
+            std::vector<Candidate> out;
+            out.reserve(results.size());
+            while (!results.empty()) {
+                out.push_back(results.top());
+                results.pop();
+            }
+            return out;
+        }
+
+        std::vector<uint32_t> HnswIndex::select_neighbors(std::vector<Candidate> candidates,
+                                                          size_t max_links) const {
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+            std::vector<uint32_t> selected;
+            selected.reserve(max_links);
+            for (const auto &candidate: candidates) {
+                if (selected.size() >= max_links) break;
+                bool keep = true;
+                for (uint32_t kept: selected) {
+                    if (similarity(matrix_.row(candidate.id), kept) > candidate.score) {
+                        keep = false;
+                        break;
+                    }
+                }
+                if (keep) selected.push_back(candidate.id);
+            }
+            return selected;
+        }
+
+        void HnswIndex::insert(uint32_t id, int level) {
+            links_[id].resize(level + 1);
+            if (max_level_ < 0) {
+                entry_point_ = id;
+                max_level_ = level;
+                return;
+            }
+
+            const float *query = matrix_.row(id);
+            Candidate current{similarity(query, entry_point_), entry_point_};
+            for (int l = max_level_; l > level; --l) {
+                current = greedy_descend(query, current, l);
+            }
+
+            std::vector<Candidate> entry{current};
+            for (int l = std::min(level, max_level_); l >= 0; --l) {
+                std::vector<Candidate> candidates = search_layer(query, entry, options_.ef_construction, l);
+                links_[id][l] = select_neighbors(candidates, options_.M);
+
+                // Link back, pruning any neighbour that now has too many links.
+                for (uint32_t neighbor: links_[id][l]) {
+                    auto &neighbor_links = links_[neighbor][l];
+                    neighbor_links.push_back(id);
+                    if (neighbor_links.size() > max_links(l)) {
+                        std::vector<Candidate> pruned;
+                        pruned.reserve(neighbor_links.size());
+                        for (uint32_t other: neighbor_links) {
+                            pruned.push_back({similarity(matrix_.row(neighbor), other), other});
+                        }
+                        neighbor_links = select_neighbors(std::move(pruned), max_links(l));
+                    }
+                }
+                entry = std::move(candidates);
+            }
+
+            if (level > max_level_) {
+                max_level_ = level;
+                entry_point_ = id;
+            }
+        }
+
+        std::vector<EmbeddingMatrix::Match> HnswIndex::search(const float *query, size_t k, size_t ef) const {
+            std::vector<EmbeddingMatrix::Match> matches;
+            if (max_level_ < 0 || k == 0) return matches;
+
+            Candidate current{similarity(query, entry_point_), entry_point_};
+            for (int l = max_level_; l > 0; --l) {
+                current = greedy_descend(query, current, l);
+            }
+            std::vector<Candidate> found = search_layer(query, {current}, std::max(ef ? ef : options_.ef_search, k),
+                                                        0);
+            std::sort(found.begin(), found.end(),
+                      [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+            if (found.size() > k) found.resize(k);
+
+            matches.reserve(found.size());
+            for (const auto &c: found) {
+                EmbeddingMatrix::Match match;
+                match.index = c.id;
+                match.score = c.score;
+                match.found = true;
+                matches.push_back(match);
+            }
+            return matches;
+        }
+
+        EmbeddingMatrix::Match HnswIndex::best_match(const float *query) const {
+            auto matches = search(query, 1);
+            return matches.empty() ? EmbeddingMatrix::Match{} : matches.front();
+        }
+    } // namespace intent
+} // namespace loki
@@ -1,9 +1,82 @@
 #include "loki/intent/IntentClassifier.h"
+#include <chrono>
 #include <iostream>
+#include <vector>
 
 namespace loki::intent {
-    IntentClassifier::IntentClassifier(loki::core::OllamaClient &ollama_client)
-        : ollama_client_(ollama_client) {
+    namespace {
+        struct IntentSchema {
+            const char *type;
+            std::vector<const char *> actions;
+        };
+
+        // Must stay in sync with the SCHEMA section of the system prompt.
+        const std::vector<IntentSchema> &intent_schema() {
+            static const std::vector<IntentSchema> schema = {
+                {"system_control", {"set_volume", "launch_application", "close_application"}},
+                {"search", {"web_search"}},
+                {"general", {"get_time", "conversation"}},
+                {"calculation", {"evaluate_expression"}},
+                {"unknown", {""}}
+            };
+            return schema;
+        }
+
+        // GBNF for one intent object. Keys come in a fixed order with at most one
+        // space between tokens, and each type only admits its own actions, so the
+        // model spends no tokens on formatting and can't pair a type with a
+        // foreign action. Parameter values are flat strings, numbers or booleans.
+        std::string build_intent_grammar() {
+            std::string intent;
+            for (const auto &entry: intent_schema()) {
+                if (!intent.empty()) intent += " | ";
+                intent += R"("\")" + std::string(entry.type) + R"(\"" ws "," ws "\"action\":" ws ()";
+                for (size_t i = 0; i < entry.actions.size(); ++i) {
+                    intent += (i ? R"( | "\")" : R"("\")") + std::string(entry.actions[i]) + R"(\"")";
+                }
+                intent += ")";
+            }
+            return R"(root ::= "{" ws "\"type\":" ws intent ws "," ws "\"parameters\":" ws params ws "," ws "\"confidence\":" ws confidence ws "}"
+intent ::= )" + intent + R"(
+params ::= "{" ws ( pair ( ws "," ws pair )* )? ws "}"
+pair ::= string ws ":" ws value
+value ::= string | number | "true" | "false" | "null"
+string ::= "\"" ( [^"\\\x7F\x00-\x1F] | "\\" ["\\/bfnrt] )* "\""
+number ::= "-"? [0-9]+ ( "." [0-9]+ )?
+confidence ::= "0" ( "." [0-9] [0-9]? )? | "1" ( ".0" )?
+ws ::= " "?
+)";
+        }
+
+        // The same language as a JSON Schema, for backends that take one (Ollama's "format").
+        // ordered_json keeps "type" before "action": Ollama emits properties in schema order.
+        std::string build_intent_json_schema() {
+            nlohmann::ordered_json variants = nlohmann::ordered_json::array();
+            for (const auto &entry: intent_schema()) {
+                nlohmann::ordered_json actions = nlohmann::ordered_json::array();
+                for (const char *action: entry.actions) actions.push_back(action);
+                variants.push_back({
+                    {"type", "object"},
+                    {
+                        "properties", {
+                            {"type", {{"const", entry.type}}},
+                            {"action", {{"enum", actions}}},
+                            {"parameters", {{"type", "object"}}},
+                            {"confidence", {{"type", "number"}, {"minimum", 0}, {"maximum", 1}}}
+                        }
+                    },
+                    {"required", {"type", "action", "parameters", "confidence"}},
+                    {"additionalProperties", false}
+                });
+            }
+            return nlohmann::ordered_json{{"anyOf", variants}}.dump();
+        }
+    } // namespace
+
+    IntentClassifier::IntentClassifier(loki::core::ILLMBackend &backend, bool constrain_output)
+        : backend_(backend), constrain_output_(constrain_output) {
+        output_format_.gbnf = build_intent_grammar();
+        output_format_.json_schema = build_intent_json_schema();
         // This is the prompt engineering heart of the controller LLM.
         // It's much stricter than our previous prompt.
         system_prompt_ = R"(
@@ -45,14 +118,23 @@ User: "calculate 5 times 8"
 User: "fsdjakl fjdsa"
 {"type":"unknown","action":"","parameters":{},"confidence":0.1}
 )";
+        // The prompt never changes, so backends that can keep it in the KV cache
+        // evaluate it once here instead of on every command.
+        backend_.prefill(system_prompt_);
     }
 
 
     loki::intent::Intent IntentClassifier::classify(const std::string &transcript) {
         std::cout << "--- Classifying intent for: \"" << transcript << "\"" << std::endl;
-        std::string llm_response_str = ollama_client_.generate(system_prompt_, transcript);
+        if (constrain_output_) {
+            return parse_response(backend_.generate_json(system_prompt_, transcript, output_format_));
+        }
+        return parse_response(backend_.generate_json(system_prompt_, transcript));
+    }
 
+    loki::intent::Intent IntentClassifier::parse_response(const std::string &llm_response_str) const {
         loki::intent::Intent result_intent;
+        responses_parsed_.fetch_add(1, std::memory_order_relaxed);
         std::string json_to_parse = llm_response_str;
         size_t first_brace = llm_response_str.find('{');
         size_t last_brace = llm_response_str.rfind('}');
@@ -75,6 +157,8 @@ User: "fsdjakl fjdsa"
             std::cerr << "ERROR: Failed to parse or validate LLM JSON response. " << e.what() << std::endl;
             std::cerr << "Raw response was: " << llm_response_str << std::endl;
 
+            parse_failures_.fetch_add(1, std::memory_order_relaxed);
+
             // Return a safe, 'unknown' intent on any failure
             result_intent.type = "unknown";
             result_intent.confidence = 0.0f;
@@ -84,4 +168,63 @@ User: "fsdjakl fjdsa"
 
         return result_intent;
     }
-}
+
+    std::unique_ptr<IntentClassifier::Speculation> IntentClassifier::classify_speculative(
+        const std::string &transcript) {
+        std::unique_ptr<Speculation> speculation(new Speculation(*this));
+        speculations_started_.fetch_add(1, std::memory_order_relaxed);
+        // The flag is shared so the request thread never outlives what it reads.
+        std::shared_ptr<std::atomic<bool> > cancelled = speculation->cancelled_;
+        speculation->result_ = std::async(std::launch::async, [this, transcript, cancelled] {
+            const std::string response = constrain_output_
+                                             ? backend_.generate_json(system_prompt_, transcript, output_format_,
+                                                                      *cancelled)
+                                             : backend_.generate_json(system_prompt_, transcript, *cancelled);
+            if (cancelled->load()) {
+                return loki::intent::Intent(); // Nobody is waiting for it
+            }
+            return parse_response(response);
+        });
+        return speculation;
+    }
+
+    IntentClassifier::SpeculationStats IntentClassifier::speculation_stats() const {
+        SpeculationStats stats;
+        stats.started = speculations_started_.load(std::memory_order_relaxed);
+        stats.used = speculations_used_.load(std::memory_order_relaxed);
+        stats.cancelled = speculations_cancelled_.load(std::memory_order_relaxed);
+        stats.discarded = speculations_discarded_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    IntentClassifier::ParseStats IntentClassifier::parse_stats() const {
+        ParseStats stats;
+        stats.responses = responses_parsed_.load(std::memory_order_relaxed);
+        stats.failures = parse_failures_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    IntentClassifier::Speculation::~Speculation() {
+        cancel();
+        // std::future from std::async joins here; the aborted request returns quickly.
+    }
+
+    loki::intent::Intent IntentClassifier::Speculation::get() {
+        if (settled_) return loki::intent::Intent();
+        settled_ = true;
+        owner_.speculations_used_.fetch_add(1, std::memory_order_relaxed);
+        return result_.get();
+    }
+
+    void IntentClassifier::Speculation::cancel() {
+        if (settled_) return;
+        settled_ = true;
+        if (result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            owner_.speculations_discarded_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        cancelled_->store(true);
+        owner_.backend_.cancel();
+        owner_.speculations_cancelled_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "loki/intent/SemanticIntentCache.h"
+#include "loki/intent/EmbeddingMatrix.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace loki {
+    namespace intent {
+        namespace {
+            constexpr int CACHE_VERSION = 1;
+
+            int64_t unix_now() {
+                return std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+        } // namespace
+
+        SemanticIntentCache::Options SemanticIntentCache::Options::from_config(const loki::core::Config &config) {
+            Options options;
+            options.capacity = std::stoul(config.get("LLM_CACHE_SIZE", "512"));
+            options.threshold = config.get_float("LLM_CACHE_THRESHOLD", 0.92f);
+            options.ttl_seconds = std::stoll(config.get("LLM_CACHE_TTL_S", "604800"));
+            options.path = config.get_path("LLM_CACHE_PATH", "llm_intent_cache.json");
+            return options;
+        }
+
+        SemanticIntentCache::SemanticIntentCache(const FastClassifier &fast_classifier, uint64_t model_hash,
+                                                 const Options &options)
+            : fast_classifier_(fast_classifier), model_hash_(model_hash), options_(options) {
+            stats_.capacity = options_.capacity;
+            if (options_.capacity > 0 && !options_.path.empty()) load();
+        }
+
+        SemanticIntentCache::~SemanticIntentCache() {
+            save();
+        }
+
+        bool SemanticIntentCache::is_expired(const Entry &entry, int64_t now) const {
+            return options_.ttl_seconds > 0 && now - entry.created >= options_.ttl_seconds;
+        }
+
+        bool SemanticIntentCache::lookup(const std::string &transcript, Intent &intent) {
+            if (options_.capacity == 0) return false;
+            const std::string normalized = normalize_text(transcript);
+            std::vector<float> embedding;
+            const bool embedded = fast_classifier_.transcript_embedding(transcript, embedding);
+
+            std::lock_guard<std::mutex> lock(mtx_);
+            stats_.lookups++;
+            const int64_t now = unix_now();
+            Entry *best = nullptr; // Always before `it`, so erasing behind it is safe
+            float best_score = options_.threshold;
+            for (auto it = entries_.begin(); it != entries_.end();) {
+                if (is_expired(*it, now)) {
+                    it = entries_.erase(it);
+                    stats_.expired++;
+                    dirty_ = true;
+                    continue;
+                }
+                if (it->transcript == normalized) {
+                    it->last_used = ++clock_;
+                    intent = it->intent;
+                    stats_.hits++;
+                    stats_.exact_hits++;
+                    return true;
+                }
+                if (embedded && it->embedding.size() == embedding.size()) {
+                    const float score = EmbeddingMatrix::dot(it->embedding.data(), embedding.data(), embedding.size());
+                    if (score >= best_score) {
+                        best_score = score;
+                        best = &*it;
+                    }
+                }
+                ++it;
+            }
+            if (!best) return false;
+
+            // The stored parameters belong to the old transcript. Only take the
+            // hit if every one of them can be read off the new transcript.
+            nlohmann::json parameters = fast_classifier_.extract_parameters(best->intent.action, transcript);
+            for (const auto &item: best->intent.parameters.items()) {
+                if (!parameters.contains(item.key())) {
+                    stats_.rejected++;
+                    return false;
+                }
+            }
+            best->last_used = ++clock_;
+            intent = best->intent;
+            intent.parameters = parameters;
+            stats_.hits++;
+            return true;
+        }
+
+        void SemanticIntentCache::insert(const std::string &transcript, const Intent &intent) {
+            if (options_.capacity == 0 || intent.type == "unknown" || intent.confidence < options_.min_confidence) {
+                return;
+            }
+            Entry entry;
+            entry.transcript = normalize_text(transcript);
+            entry.intent = intent;
+            entry.created = unix_now();
+            if (!fast_classifier_.transcript_embedding(transcript, entry.embedding)) return;
+
+            std::lock_guard<std::mutex> lock(mtx_);
+            entry.last_used = ++clock_;
+            for (auto &existing: entries_) {
+                if (existing.transcript == entry.transcript) {
+                    existing = std::move(entry);
+                    stats_.inserts++;
+                    dirty_ = true;
+                    return;
+                }
+            }
+            if (entries_.size() >= options_.capacity) {
+                // Expired entries go first, then the least recently used one.
+                const int64_t now = unix_now();
+                auto victim = entries_.begin();
+                for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                    if (is_expired(*it, now)) {
+                        victim = it;
+                        break;
+                    }
+                    if (it->last_used < victim->last_used) victim = it;
+                }
+                entries_.erase(victim);
+                stats_.evictions++;
+            }
+            entries_.push_back(std::move(entry));
+            stats_.inserts++;
+            dirty_ = true;
+        }
+
+        SemanticIntentCache::Stats SemanticIntentCache::stats() const {
+            std::lock_guard<std::mutex> lock(mtx_);
+            Stats stats = stats_;
+            stats.size = entries_.size();
+            return stats;
+        }
+
+        void SemanticIntentCache::load() {
+            std::ifstream in(options_.path);
+            if (!in.is_open()) return; // First run
+            const nlohmann::json file = nlohmann::json::parse(in, nullptr, false);
+            if (file.is_discarded() || !file.is_object() || file.value("version", 0) != CACHE_VERSION) {
+                std::cerr << "WARNING: Ignoring unreadable semantic intent cache '" << options_.path << "'" << std::endl;
+                return;
+            }
+            if (file.value("model_hash", uint64_t{0}) != model_hash_) {
+                std::cout << "Semantic intent cache was built with another embedding model; starting empty."
+                        << std::endl;
+                return;
+            }
+
+            const int64_t now = unix_now();
+            try {
+                for (const auto &item: file.at("entries")) {
+                    Entry entry;
+                    entry.transcript = item.at("transcript").get<std::string>();
+                    entry.intent.type = item.at("type").get<std::string>();
+                    entry.intent.action = item.at("action").get<std::string>();
+                    entry.intent.parameters = item.at("parameters");
+                    entry.intent.confidence = item.at("confidence").get<float>();
+                    entry.created = item.at("created").get<int64_t>();
+                    entry.embedding = item.at("embedding").get<std::vector<float> >();
+                    if (is_expired(entry, now) || !EmbeddingMatrix::normalize(entry.embedding)) continue;
+                    entry.last_used = ++clock_; // File order is oldest use first
+                    entries_.push_back(std::move(entry));
+                    if (entries_.size() == options_.capacity) break;
+                }
+            } catch (const nlohmann::json::exception &e) {
+                std::cerr << "WARNING: Semantic intent cache '" << options_.path << "' is damaged: " << e.what()
+                        << std::endl;
+            }
+            std::cout << "Loaded " << entries_.size() << " cached LLM intents from '" << options_.path << "'."
+                    << std::endl;
+        }
+
+        bool SemanticIntentCache::save() {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!dirty_ || options_.path.empty()) return true;
+
+            std::vector<const Entry *> ordered;
+            for (const auto &entry: entries_) ordered.push_back(&entry);
+            std::sort(ordered.begin(), ordered.end(), [](const Entry *a, const Entry *b) {
+                return a->last_used < b->last_used;
+            });
+            nlohmann::json entries = nlohmann::json::array();
+            for (const Entry *entry: ordered) {
+                entries.push_back({
+                    {"transcript", entry->transcript},
+                    {"type", entry->intent.type},
+                    {"action", entry->intent.action},
+                    {"parameters", entry->intent.parameters},
+                    {"confidence", entry->intent.confidence},
+                    {"created", entry->created},
+                    {"embedding", entry->embedding}
+                });
+            }
+            const nlohmann::json file = {
+                {"version", CACHE_VERSION},
+                {"model_hash", model_hash_},
+                {"entries", entries}
+            };
+
+            // Write beside the target and rename, so a crash never leaves a torn file.
+            const std::string tmp_path = options_.path + ".tmp";
+            {
+                std::ofstream out(tmp_path, std::ios::trunc);
+                if (!out.is_open()) {
+                    std::cerr << "WARNING: Could not write semantic intent cache '" << tmp_path << "'" << std::endl;
+                    return false;
+                }
+                out << file.dump();
+                if (!out.good()) {
+                    std::cerr << "WARNING: Failed while writing semantic intent cache '" << tmp_path << "'"
+                            << std::endl;
+                    out.close();
+                    std::remove(tmp_path.c_str());
+                    return false;
+                }
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmp_path, options_.path, ec);
+            if (ec) {
+                std::cerr << "WARNING: Could not replace semantic intent cache '" << options_.path << "': "
+                        << ec.message() << std::endl;
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+            dirty_ = false;
+            return true;
+        }
+    } // namespace intent
+} // namespace loki
@@ -0,0 +1,286 @@
+#include "loki/intent/SlotExtractor.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <limits>
+#include <queue>
+
+namespace loki {
+    namespace intent {
+        namespace {
+            constexpr uint32_t ANY_ACTION = std::numeric_limits<uint32_t>::max();
+            constexpr size_t NO_POSITION = std::numeric_limits<size_t>::max();
+
+            struct NumberWord {
+                const char *text;
+                int value;
+            };
+
+            const NumberWord NUMBER_WORDS[] = {
+                {"zero", 0}, {"one", 1}, {"two", 2}, {"three", 3}, {"four", 4}, {"five", 5}, {"six", 6},
+                {"seven", 7}, {"eight", 8}, {"nine", 9}, {"ten", 10}, {"eleven", 11}, {"twelve", 12},
+                {"thirteen", 13}, {"fourteen", 14}, {"fifteen", 15}, {"sixteen", 16}, {"seventeen", 17},
+                {"eighteen", 18}, {"nineteen", 19}, {"twenty", 20}, {"thirty", 30}, {"forty", 40}, {"fifty", 50},
+                {"sixty", 60}, {"seventy", 70}, {"eighty", 80}, {"ninety", 90}
+            };
+
+            bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+            bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+            // One number word or digit run, before "twenty five" style words are joined.
+            struct NumberToken {
+                size_t start;
+                size_t end;
+                int value;
+                bool digits;
+                bool hundred;
+            };
+
+            struct Number {
+                size_t start;
+                size_t end;
+                int value;
+                const NumberToken *last; // Last token joined into this number
+            };
+
+            // Whether `token` continues the spoken number `number` ("twenty" + "five",
+            // "two" + "hundred", "one hundred" + "ten"). Digit runs never join.
+            bool continues(const Number &number, const NumberToken &token) {
+                const NumberToken &last = *number.last;
+                if (token.digits || last.digits || token.start != number.end + 1) return false;
+                if (token.hundred) return !last.hundred && number.value > 0 && number.value < 100;
+                if (last.hundred) return token.value > 0 && token.value < 100;
+                // Tens followed by a unit
+                return last.value >= 20 && last.value % 10 == 0 && token.value > 0 && token.value < 10;
+            }
+        } // namespace
+
+        uint32_t SlotExtractor::action_id(const std::string &action) {
+            auto inserted = action_ids_.emplace(action, static_cast<uint32_t>(slots_.size()));
+            if (inserted.second) slots_.emplace_back();
+            return inserted.first->second;
+        }
+
+        uint32_t SlotExtractor::slot_id(uint32_t action, const std::string &slot) {
+            auto &defs = slots_[action];
+            for (size_t i = 0; i < defs.size(); ++i) {
+                if (defs[i].name == slot) return static_cast<uint32_t>(i);
+            }
+            SlotDef def;
+            def.name = slot;
+            defs.push_back(def);
+            return static_cast<uint32_t>(defs.size() - 1);
+        }
+
+        void SlotExtractor::add_pattern(Pattern pattern) {
+            if (pattern.text.empty()) return;
+            pattern.length = static_cast<uint32_t>(pattern.text.size());
+            patterns_.push_back(std::move(pattern));
+        }
+
+        void SlotExtractor::add_phrase(const std::string &action, const std::string &slot, const std::string &phrase,
+                                       const std::string &value) {
+            Pattern pattern;
+            pattern.kind = PatternKind::Phrase;
+            pattern.action = action_id(action);
+            pattern.slot = slot_id(pattern.action, slot);
+            pattern.value = value;
+            pattern.text = phrase;
+            add_pattern(std::move(pattern));
+        }
+
+        void SlotExtractor::add_numeric_slot(const std::string &action, const std::string &slot, NumericKind kind) {
+            const uint32_t action_index = action_id(action);
+            SlotDef &def = slots_[action_index][slot_id(action_index, slot)];
+            def.numeric = true;
+            def.numeric_kind = kind;
+
+            // Number words are shared by every numeric slot, so they go in once.
+            for (const auto &pattern: patterns_) {
+                if (pattern.kind == PatternKind::NumberWord) return;
+            }
+            for (const auto &word: NUMBER_WORDS) {
+                Pattern pattern;
+                pattern.kind = PatternKind::NumberWord;
+                pattern.action = ANY_ACTION;
+                pattern.value_number = word.value;
+                pattern.text = word.text;
+                add_pattern(std::move(pattern));
+            }
+            Pattern hundred;
+            hundred.kind = PatternKind::Hundred;
+            hundred.action = ANY_ACTION;
+            hundred.value_number = 100;
+            hundred.text = "hundred";
+            add_pattern(std::move(hundred));
+            Pattern percent;
+            percent.kind = PatternKind::PercentWord;
+            percent.action = ANY_ACTION;
+            percent.text = "percent";
+            add_pattern(std::move(percent));
+        }
+
+        void SlotExtractor::compile() {
+            // Only bytes that occur in some pattern get their own class; every
+            // other byte shares class 0, which always leads back to the root.
+            std::fill(std::begin(byte_class_), std::end(byte_class_), 0);
+            alphabet_size_ = 1;
+            for (const auto &pattern: patterns_) {
+                for (char c: pattern.text) {
+                    uint16_t &cls = byte_class_[static_cast<unsigned char>(c)];
+                    if (cls == 0) cls = static_cast<uint16_t>(alphabet_size_++);
+                }
+            }
+
+            // Trie of all patterns; -1 marks a missing edge until the BFS below fills it.
+            delta_.assign(alphabet_size_, -1);
+            outputs_.assign(1, {});
+            for (size_t id = 0; id < patterns_.size(); ++id) {
+                int32_t state = 0;
+                for (char c: patterns_[id].text) {
+                    const size_t edge = state * alphabet_size_ + byte_class_[static_cast<unsigned char>(c)];
+                    if (delta_[edge] < 0) {
+                        delta_[edge] = static_cast<int32_t>(outputs_.size());
+                        outputs_.emplace_back();
+                        delta_.resize(delta_.size() + alphabet_size_, -1);
+                    }
+                    state = delta_[edge];
+                }
+                outputs_[state].push_back(static_cast<uint32_t>(id));
+            }
+
+            // Breadth-first, so a state's suffix link is finished before its children
+            // need it. Missing edges become the suffix link's edge, turning the trie
+            // into a DFA; outputs are merged along suffix links.
+            std::vector<int32_t> suffix_link(outputs_.size(), 0);
+            std::queue<int32_t> pending;
+            for (size_t cls = 0; cls < alphabet_size_; ++cls) {
+                if (delta_[cls] < 0) {
+                    delta_[cls] = 0;
+                } else {
+                    pending.push(delta_[cls]);
+                }
+            }
+            while (!pending.empty()) {
+                const int32_t state = pending.front();
+                pending.pop();
+                for (size_t cls = 0; cls < alphabet_size_; ++cls) {
+                    int32_t &next = delta_[state * alphabet_size_ + cls];
+                    const int32_t fallback = delta_[suffix_link[state] * alphabet_size_ + cls];
+                    if (next < 0) {
+                        next = fallback;
+                        continue;
+                    }
+                    suffix_link[next] = fallback;
+                    const auto &inherited = outputs_[fallback];
+                    outputs_[next].insert(outputs_[next].end(), inherited.begin(), inherited.end());
+                    pending.push(next);
+                }
+            }
+        }
+
+        nlohmann::json SlotExtractor::extract(const std::string &action, const std::string &normalized_text) const {
+            nlohmann::json slots = nlohmann::json::object();
+            auto action_it = action_ids_.find(action);
+            if (action_it == action_ids_.end() || delta_.empty()) return slots;
+            const uint32_t current_action = action_it->second;
+            const auto &defs = slots_[current_action];
+
+            struct Best {
+                size_t start = NO_POSITION;
+                uint32_t length = 0;
+                const std::string *value = nullptr;
+            };
+            std::vector<Best> best(defs.size());
+            std::vector<NumberToken> tokens;
+            std::vector<size_t> percent_starts;
+
+            const std::string &text = normalized_text;
+            const size_t n = text.size();
+            int32_t state = 0;
+            size_t digit_start = NO_POSITION;
+            for (size_t i = 0; i < n; ++i) {
+                state = delta_[state * alphabet_size_ + byte_class_[static_cast<unsigned char>(text[i])]];
+                const bool ends_word = i + 1 == n || is_space(text[i + 1]);
+                for (uint32_t id: outputs_[state]) {
+                    const Pattern &pattern = patterns_[id];
+                    const size_t start = i + 1 - pattern.length;
+                    if (!ends_word || (start > 0 && !is_space(text[start - 1]))) continue;
+                    switch (pattern.kind) {
+                        case PatternKind::Phrase: {
+                            if (pattern.action != current_action) break;
+                            Best &b = best[pattern.slot];
+                            if (start < b.start || (start == b.start && pattern.length > b.length)) {
+                                b.start = start;
+                                b.length = pattern.length;
+                                b.value = &pattern.value;
+                            }
+                            break;
+                        }
+                        case PatternKind::NumberWord:
+                        case PatternKind::Hundred:
+                            tokens.push_back({
+                                start, i + 1, pattern.value_number, false, pattern.kind == PatternKind::Hundred
+                            });
+                            break;
+                        case PatternKind::PercentWord:
+                            percent_starts.push_back(start);
+                            break;
+                    }
+                }
+
+                // Whole-word digit runs ("50", but not "mp3") are read in the same pass.
+                if (is_digit(text[i])) {
+                    if (i == 0 || is_space(text[i - 1])) digit_start = i;
+                    if (i + 1 == n || !is_digit(text[i + 1])) {
+                        if (digit_start != NO_POSITION && ends_word && i + 1 - digit_start <= 9) {
+                            tokens.push_back({
+                                digit_start, i + 1, std::stoi(text.substr(digit_start, i + 1 - digit_start)), true,
+                                false
+                            });
+                        }
+                        digit_start = NO_POSITION;
+                    }
+                }
+            }
+
+            for (size_t s = 0; s < defs.size(); ++s) {
+                if (best[s].value) slots[defs[s].name] = *best[s].value;
+            }
+            if (tokens.empty()) return slots;
+
+            // Tokens arrive in text order; join spoken numbers into values.
+            std::vector<Number> numbers;
+            for (const auto &token: tokens) {
+                if (!numbers.empty() && continues(numbers.back(), token)) {
+                    Number &number = numbers.back();
+                    number.value = token.hundred ? number.value * 100 : number.value + token.value;
+                    number.end = token.end;
+                    number.last = &token;
+                } else {
+                    numbers.push_back({token.start, token.end, token.value, &token});
+                }
+            }
+
+            for (const auto &def: defs) {
+                if (!def.numeric) continue;
+                const Number *chosen = nullptr;
+                if (def.numeric_kind == NumericKind::Percent) {
+                    for (const auto &number: numbers) {
+                        for (size_t start: percent_starts) {
+                            if (start == number.end + 1) chosen = &number;
+                        }
+                        if (chosen) break;
+                    }
+                    for (size_t i = 0; !chosen && i < numbers.size(); ++i) {
+                        if (numbers[i].value <= 100) chosen = &numbers[i];
+                    }
+                } else {
+                    chosen = &numbers.front();
+                }
+                if (chosen) slots[def.name] = chosen->value;
+            }
+            return slots;
+        }
+    } // namespace intent
+} // namespace loki
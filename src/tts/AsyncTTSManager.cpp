@@ -1,4 +1,5 @@
 #include "loki/tts/AsyncTTSManager.h"
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QMutexLocker>
 #include <QVariant>
@@ -114,20 +115,27 @@ namespace loki::tts {
 
         auto syncOp = std::make_shared<SyncOperation>();
 
-        uint64_t requestId = workerThread_->synthesizeAsync(text, TTSPriority::HIGH);
-        if (requestId == 0) {
-            std::cout << "ASYNC_TTS_LOG: Failed to queue sync TTS request" << std::endl;
-            return false;
-        } {
+        // Queue and register under syncMutex_: onSynthesisCompleted takes the same
+        // lock, so a result that arrives before the registration can't be lost.
+        uint64_t requestId = 0; {
             QMutexLocker locker(&syncMutex_);
+            requestId = workerThread_->synthesizeAsync(text, TTSPriority::HIGH);
+            if (requestId == 0) {
+                std::cout << "ASYNC_TTS_LOG: Failed to queue sync TTS request" << std::endl;
+                return false;
+            }
             syncOperations_[requestId] = syncOp;
         }
 
-        // Wait for completion
+        // Wait for completion. syncCondition_ is shared by every sync operation,
+        // so a wakeup may be for another request; keep waiting until the deadline.
         {
+            QDeadlineTimer deadline(timeoutMs);
             QMutexLocker locker(&syncMutex_);
-            if (!syncOp->completed) {
-                syncCondition_.wait(&syncMutex_, timeoutMs);
+            while (!syncOp->completed) {
+                if (!syncCondition_.wait(&syncMutex_, deadline)) {
+                    break;
+                }
             }
         }
 